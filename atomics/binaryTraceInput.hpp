@@ -0,0 +1,106 @@
+/**
+* ARSLab - Carleton University
+*
+* Binary Trace Input:
+* Desktop replacements for the AnalogInput/DigitalInput file models that replay a
+* binary trace (see utilities/binary_trace.hpp) instead of parsing a text file.
+* They use the same port definitions, so the couplings of the top model do not change.
+*/
+#ifndef SEEED_BOT_BINARY_TRACE_INPUT_HPP
+#define SEEED_BOT_BINARY_TRACE_INPUT_HPP
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/real_time/arm_mbed/io/digitalInput.hpp>
+#include <cadmium/real_time/arm_mbed/io/analogInput.hpp>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "../utilities/binary_trace.hpp"
+#include "../utilities/time_conversion.hpp"
+
+    template<typename VALUE, typename TIME, typename DEFS>
+    class binary_trace_input {
+        using defs=DEFS; // putting definitions in context
+        public:
+            binary_trace_input() noexcept{
+              state.done = true;
+            }
+
+            binary_trace_input(const char* file_path) {
+              reader = std::make_shared<BinaryTraceReader<VALUE>>(file_path);
+              state.last_us = 0;
+              state.done = !reader->next(state.next_us, state.value);
+            }
+
+            // state definition
+            struct state_type{
+              long long last_us; // time of the last sample sent
+              long long next_us; // time of the sample to send next
+              VALUE value;
+              bool done;
+            };
+            state_type state;
+
+            // ports definition
+            using input_ports=std::tuple<>;
+            using output_ports=std::tuple<typename defs::out>;
+
+            // internal transition
+            void internal_transition() {
+              state.last_us = state.next_us;
+              state.done = !reader->next(state.next_us, state.value);
+            }
+
+            // external transition
+            void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              throw std::logic_error("External transition called in a model with no input ports");
+            }
+
+            // confluence transition
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              internal_transition();
+              external_transition(TIME(), std::move(mbs));
+            }
+
+            // output function
+            typename cadmium::make_message_bags<output_ports>::type output() const {
+              typename cadmium::make_message_bags<output_ports>::type bags;
+              cadmium::get_messages<typename defs::out>(bags).push_back(state.value);
+              return bags;
+            }
+
+            // time_advance function
+            TIME time_advance() const {
+              if(state.done) {
+                return std::numeric_limits<TIME>::infinity();
+              }
+              return from_microseconds<TIME>(state.next_us - state.last_us);
+            }
+
+            friend std::ostringstream& operator<<(std::ostringstream& os, const typename binary_trace_input<VALUE, TIME, DEFS>::state_type& i) {
+              os << "Next value: " << i.value;
+              return os;
+            }
+
+        private:
+            std::shared_ptr<BinaryTraceReader<VALUE>> reader;
+    };
+
+    template<typename TIME>
+    class BinaryAnalogInput : public binary_trace_input<float, TIME, analogInput_defs> {
+        public:
+            BinaryAnalogInput() = default;
+            BinaryAnalogInput(const char* file_path) : binary_trace_input<float, TIME, analogInput_defs>(file_path) {}
+    };
+
+    template<typename TIME>
+    class BinaryDigitalInput : public binary_trace_input<bool, TIME, digitalInput_defs> {
+        public:
+            BinaryDigitalInput() = default;
+            BinaryDigitalInput(const char* file_path) : binary_trace_input<bool, TIME, digitalInput_defs>(file_path) {}
+    };
+
+#endif // SEEED_BOT_BINARY_TRACE_INPUT_HPP
@@ -0,0 +1,228 @@
+/**
+* ARSLab - Carleton University
+*
+* Controller:
+* Drive controller for the Seeed Bot Shield, shared by LightBot and SeeedBotDriver.
+* A sensor-decision POLICY, resolved at compile time, reads its sensor ports, picks a
+* DriveState and maps it to the four motor values. The controller does the rest: the DEVS
+* functions and change detection on the motor ports (only ports whose value changes are sent).
+*
+* A POLICY provides:
+*   input_ports                                  tuple of its sensor ports
+*   sensor_state                                 last value read from each sensor
+*   initial                                      DriveState before the first sample
+*   void read(sensor_state&, BAGS&)              stores the messages of an external transition
+*   DriveState decide(const sensor_state&)       drive direction for the current readings
+*   motor_command command(DriveState, const sensor_state&)   motor values to send
+*   static motor_command motors(DriveState)      its motor table (not needed by switchable_policy)
+*
+* switchable_policy<A, B> puts two policies in one controller, selected at run time
+* by the mode port, without virtual dispatch.
+*/
+#ifndef SEEED_BOT_CONTROLLER_HPP
+#define SEEED_BOT_CONTROLLER_HPP
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#ifdef FIXED_MESSAGE_BAGS
+  #include "../data_structures/fixed_message_bag.hpp"
+#endif
+#include <limits>
+#include <sstream>
+#include <tuple>
+#include <utility>
+
+enum class DriveState : unsigned char {right = 0, straight = 1, left = 2, stop = 3, unknown = 4};
+
+// Values for the four motor ports.
+struct motor_command {
+  float rightMotor1;
+  bool rightMotor2;
+  float leftMotor1;
+  bool leftMotor2;
+};
+
+//Port definition
+    struct controller_defs {
+        //Output ports
+        struct rightMotor1 : public cadmium::out_port<float> { };
+        struct rightMotor2 : public cadmium::out_port<bool> { };
+        struct leftMotor1 : public cadmium::out_port<float> { };
+        struct leftMotor2 : public cadmium::out_port<bool> { };
+        //Input ports
+        struct mode : public cadmium::in_port<bool> { }; // switchable_policy: false = first policy, true = second
+    };
+
+#ifdef FIXED_MESSAGE_BAGS
+  FIXED_MESSAGE_BAG(controller_defs::rightMotor1, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(controller_defs::rightMotor2, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(controller_defs::leftMotor1, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(controller_defs::leftMotor2, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(controller_defs::mode, FIXED_MESSAGE_BAG_CAPACITY)
+#endif
+
+    template<typename POLICY, typename TIME>
+    class Controller {
+        using defs=controller_defs; // putting definitions in context
+        public:
+            //Parameters to be overwriten when instantiating the atomic model
+            // When set, only the motor ports whose value changed are woken up and emitted.
+            bool   changeDetection;
+            POLICY policy;
+
+            // default constructor
+            Controller() noexcept{
+              reset();
+            }
+
+            Controller(bool onlyOnChange) noexcept{
+              reset();
+              changeDetection = onlyOnChange;
+            }
+
+            // Remaining arguments are passed to the policy constructor.
+            template<typename... ARGs>
+            Controller(bool onlyOnChange, ARGs&&... policyArgs) : policy(std::forward<ARGs>(policyArgs)...) {
+              reset();
+              changeDetection = onlyOnChange;
+            }
+
+            enum motor_port {RIGHT_MOTOR1 = 1, RIGHT_MOTOR2 = 2, LEFT_MOTOR1 = 4, LEFT_MOTOR2 = 8, ALL_MOTORS = 15};
+
+            // state definition
+            struct state_type{
+              DriveState dir;
+              bool prop;
+              typename POLICY::sensor_state sensors;
+              motor_command command;    // values for the current direction
+              motor_command sent;       // values last emitted on each port
+              unsigned char pending;    // motor ports waiting to be emitted
+              bool primed;              // false until the first output, so every port is sent once
+              unsigned long suppressed; // sensor events that did not need an output
+            };
+            state_type state;
+
+            // ports definition
+            using input_ports=typename POLICY::input_ports;
+            using output_ports=std::tuple<typename defs::rightMotor1, typename defs::rightMotor2, typename defs::leftMotor1, typename defs::leftMotor2>;
+
+            // internal transition
+            void internal_transition() {
+              state.sent = state.command;
+              state.pending = 0;
+              state.primed = true;
+              state.prop = false;
+            }
+
+            // external transition
+            void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              // Only the last value of each sensor is kept, the decision uses the latest reading of all of them.
+              policy.read(state.sensors, mbs);
+              state.dir = policy.decide(state.sensors);
+              state.command = policy.command(state.dir, state.sensors);
+
+              if(changeDetection && state.primed) {
+                state.pending = changedPorts(state.command, state.sent);
+              } else {
+                state.pending = ALL_MOTORS;
+              }
+              state.prop = state.pending != 0;
+              if(!state.prop) {
+                state.suppressed++;
+              }
+            }
+
+            // confluence transition
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              internal_transition();
+              external_transition(TIME(), std::move(mbs));
+            }
+
+            // output function
+            typename cadmium::make_message_bags<output_ports>::type output() const {
+              typename cadmium::make_message_bags<output_ports>::type bags;
+
+              if(state.pending & RIGHT_MOTOR1) cadmium::get_messages<typename defs::rightMotor1>(bags).push_back(state.command.rightMotor1);
+              if(state.pending & RIGHT_MOTOR2) cadmium::get_messages<typename defs::rightMotor2>(bags).push_back(state.command.rightMotor2);
+              if(state.pending & LEFT_MOTOR1) cadmium::get_messages<typename defs::leftMotor1>(bags).push_back(state.command.leftMotor1);
+              if(state.pending & LEFT_MOTOR2) cadmium::get_messages<typename defs::leftMotor2>(bags).push_back(state.command.leftMotor2);
+
+              return bags;
+            }
+
+            // time_advance function
+            TIME time_advance() const {
+              if(state.prop) {
+                return TIME();
+              }
+              return std::numeric_limits<TIME>::infinity();
+            }
+
+            // Motor values of the policy for each drive direction.
+            static motor_command motorCommand(DriveState dir) {
+              return POLICY::motors(dir);
+            }
+
+            friend std::ostringstream& operator<<(std::ostringstream& os, const typename Controller<POLICY, TIME>::state_type& i) {
+              os << "Current state: " << (int) i.dir << " Suppressed: " << i.suppressed;
+              return os;
+            }
+
+        private:
+            void reset() {
+              changeDetection = true;
+              state.dir = POLICY::initial;
+              state.prop = false;
+              state.sensors = typename POLICY::sensor_state();
+              state.pending = 0;
+              state.primed = false;
+              state.suppressed = 0;
+            }
+
+            static unsigned char changedPorts(const motor_command& now, const motor_command& before) {
+              unsigned char ports = 0;
+              if(now.rightMotor1 != before.rightMotor1) ports |= RIGHT_MOTOR1;
+              if(now.rightMotor2 != before.rightMotor2) ports |= RIGHT_MOTOR2;
+              if(now.leftMotor1 != before.leftMotor1) ports |= LEFT_MOTOR1;
+              if(now.leftMotor2 != before.leftMotor2) ports |= LEFT_MOTOR2;
+              return ports;
+            }
+    };
+
+    // Two policies in one controller: the mode port selects which one drives.
+    // Both keep reading their sensors, so switching takes effect on the next sample.
+    template<typename FIRST, typename SECOND>
+    struct switchable_policy {
+        using input_ports=decltype(std::tuple_cat(std::declval<typename FIRST::input_ports>(),
+                                                  std::declval<typename SECOND::input_ports>(),
+                                                  std::declval<std::tuple<controller_defs::mode>>()));
+        static constexpr DriveState initial = FIRST::initial;
+
+        FIRST first;
+        SECOND second;
+
+        struct sensor_state {
+          typename FIRST::sensor_state first;
+          typename SECOND::sensor_state second;
+          bool useSecond;
+        };
+
+        template<typename BAGS>
+        void read(sensor_state& s, BAGS& mbs) const {
+          first.read(s.first, mbs);
+          second.read(s.second, mbs);
+          for(const auto &x : cadmium::get_messages<controller_defs::mode>(mbs)){
+            s.useSecond = x;
+          }
+        }
+
+        DriveState decide(const sensor_state& s) const {
+          return s.useSecond ? second.decide(s.second) : first.decide(s.first);
+        }
+
+        motor_command command(DriveState dir, const sensor_state& s) const {
+          return s.useSecond ? second.command(dir, s.second) : first.command(dir, s.first);
+        }
+    };
+
+#endif // SEEED_BOT_CONTROLLER_HPP
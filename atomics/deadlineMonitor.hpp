@@ -0,0 +1,227 @@
+/**
+* ARSLab - Carleton University
+*
+* Deadline Monitor:
+* Checks that the real-time execution keeps up with the model. Every transition of the wrapped
+* model is compared with the wall clock: lateness is how long after its scheduled simulation
+* time the transition actually ran. Define DEADLINE_MONITOR to turn it on; otherwise the
+* decorator is a plain pass-through.
+*
+*   const deadline_policy sensorDeadline = {2000, true};
+*   make_dynamic_atomic_model<deadline_monitor<AnalogInput>::model, TIME>("rightLightSens", instrumentation{"rightLightSens", sensorDeadline}, A5);
+*
+* Each monitored model keeps, under its name:
+*   lateness   histogram of how late the transitions ran
+*   overruns   transitions later than the policy budget
+*   zero-time  transitions at the same simulation time as the previous one (ta = 0 cascades)
+*   coalesced  samples dropped because they were stale (see below)
+* and deadline_stats::report() also prints the longest zero-time cascade of the whole model.
+*
+* Coalescing (policy.coalesce, for input models): a sample is stale when the wall clock is
+* already past the time of the next sample. Sending it would only make the controller react to
+* an old value and push the next events further back, so it is dropped and the next sample,
+* read right after, is sent instead. Models with ta = 0 (edges) are never coalesced.
+*
+* The wall clock origin is set by deadline_stats::start(), called right before run_until,
+* or by the first monitored transition. In a desktop simulation the models run ahead of the
+* wall clock and nothing is late; the numbers mean something with the real-time runner.
+*/
+#ifndef SEEED_BOT_DEADLINE_MONITOR_HPP
+#define SEEED_BOT_DEADLINE_MONITOR_HPP
+
+#include <cadmium/modeling/message_bag.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <tuple>
+#include <utility>
+
+#include "../utilities/instrumentation.hpp"
+#include "../utilities/latency_histogram.hpp"
+#include "../utilities/named_registry.hpp"
+#include "../utilities/time_conversion.hpp"
+
+#ifdef RT_ARM_MBED
+  #include "mbed.h"
+#else
+  #include <chrono>
+#endif
+
+#ifndef DEADLINE_MONITOR_MODELS
+  #define DEADLINE_MONITOR_MODELS 12
+#endif
+
+// Wall clock in microseconds. On target the 32-bit us ticker (wraps every ~71 min) is
+// extended to 64 bits, so it must be read at least once per wrap.
+struct deadline_clock {
+  static long long now_us() {
+    #ifdef RT_ARM_MBED
+      static uint32_t last = 0;
+      static uint64_t high = 0;
+      const uint32_t t = us_ticker_read();
+      if(t < last) high += (uint64_t) 1 << 32;
+      last = t;
+      return (long long) (high | t);
+    #else
+      return (long long) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    #endif
+  }
+};
+
+struct deadline_stats {
+  LatencyHistogram lateness;
+  unsigned long overruns = 0;
+  unsigned long zero_time = 0;
+  unsigned long coalesced = 0;
+
+  // Wall clock time of simulation time 0.
+  static void start(long long sim_us = 0) {
+    origin_us() = deadline_clock::now_us() - sim_us;
+    started() = true;
+  }
+
+  // How late simulation time sim_us is on the wall clock, 0 if it is not due yet.
+  static long long lateness_us(long long sim_us) {
+    if(!started()) start(sim_us);
+    const long long late = deadline_clock::now_us() - origin_us() - sim_us;
+    return late > 0 ? late : 0;
+  }
+
+  // Counts the transitions of all monitored models at the same simulation time.
+  static void instant(long long sim_us) {
+    cascade& c = cascades();
+    if(c.count > 0 && sim_us == c.time_us) {
+      c.count++;
+    } else {
+      c.time_us = sim_us;
+      c.count = 1;
+    }
+    if(c.count > c.longest) {
+      c.longest = c.count;
+      c.longest_at_us = sim_us;
+    }
+  }
+
+  // Counters registered under name, created on first use. nullptr when all slots are taken.
+  static deadline_stats* get(const char* name) {
+    return registry().get(name);
+  }
+
+  static void report(FILE* out) {
+    registry().for_each([&](const char* name, const deadline_stats& e) {
+      std::fprintf(out, "%-16s events %8lu  late p50 %8.1f p99 %8.1f max %8.1f us  overruns %6lu  zero-time %6lu  coalesced %6lu\n",
+                   name, (unsigned long) e.lateness.count(), e.lateness.percentile(50) / 1000.0,
+                   e.lateness.percentile(99) / 1000.0, e.lateness.max() / 1000.0, e.overruns, e.zero_time, e.coalesced);
+    });
+    const cascade& c = cascades();
+    std::fprintf(out, "longest cascade  %lu transitions at %s\n", c.longest, format_time_string(c.longest_at_us).c_str());
+  }
+
+  static void reset() {
+    registry().for_each([](const char*, deadline_stats& e) { e = deadline_stats(); });
+    cascades() = cascade();
+    started() = false;
+  }
+
+  private:
+    struct cascade {
+      long long time_us = 0;
+      unsigned long count = 0;
+      unsigned long longest = 0;
+      long long longest_at_us = 0;
+    };
+
+    static NamedRegistry<deadline_stats, DEADLINE_MONITOR_MODELS>& registry() {
+      static NamedRegistry<deadline_stats, DEADLINE_MONITOR_MODELS> stats;
+      return stats;
+    }
+
+    static cascade& cascades() {
+      static cascade c;
+      return c;
+    }
+
+    static long long& origin_us() {
+      static long long origin = 0;
+      return origin;
+    }
+
+    static bool& started() {
+      static bool flag = false;
+      return flag;
+    }
+};
+
+template<template<typename> class MODEL>
+struct deadline_monitor {
+    template<typename TIME>
+    class model : public decorator_base<MODEL<TIME>> {
+        using base=MODEL<TIME>;
+        public:
+            model() : decorator_base<base>(), policy{0, false}, stats(nullptr), now_us(0), last_us(-1) {}
+
+            template<typename... ARGs>
+            model(const instrumentation& config, ARGs&&... args) : decorator_base<base>(config, std::forward<ARGs>(args)...), policy(config.deadline), stats(nullptr), now_us(0), last_us(-1) {
+              #ifdef DEADLINE_MONITOR
+                stats = deadline_stats::get(config.name);
+              #endif
+            }
+
+            void internal_transition() {
+              now_us += to_microseconds(base::time_advance());
+              check();
+              base::internal_transition();
+            }
+
+            void external_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              now_us += to_microseconds(e);
+              check();
+              base::external_transition(e, std::move(mbs));
+            }
+
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              now_us += to_microseconds(e);
+              check();
+              base::confluence_transition(e, std::move(mbs));
+            }
+
+            typename cadmium::make_message_bags<typename base::output_ports>::type output() const {
+              auto bags = base::output();
+              #ifdef DEADLINE_MONITOR
+                if(policy.coalesce && stale(bags)) {
+                  std::apply([](auto&... bag) { (bag.messages.clear(), ...); }, bags);
+                }
+              #endif
+              return bags;
+            }
+
+        private:
+            // Stale: the next sample, one ta after this one, is already due.
+            template<typename BAGS>
+            bool stale(const BAGS& bags) const {
+              const long long ta_us = to_microseconds(base::time_advance());
+              const bool sending = std::apply([](const auto&... bag) { return (false || ... || !bag.messages.empty()); }, bags);
+              const bool dropped = sending && ta_us > 0 && deadline_stats::lateness_us(now_us + ta_us) >= ta_us;
+              if(dropped && stats) stats->coalesced++;
+              return dropped;
+            }
+
+            void check() {
+              #ifdef DEADLINE_MONITOR
+                if(!stats) return;
+                const long long late = deadline_stats::lateness_us(now_us);
+                stats->lateness.record((uint64_t) late * 1000);
+                if(late > policy.budget_us) stats->overruns++;
+                if(now_us == last_us) stats->zero_time++;
+                last_us = now_us;
+                deadline_stats::instant(now_us);
+              #endif
+            }
+
+            deadline_policy policy;
+            deadline_stats* stats;
+            long long now_us;  // simulation time of the last transition
+            long long last_us; // simulation time of the one before
+    };
+};
+
+#endif // SEEED_BOT_DEADLINE_MONITOR_HPP
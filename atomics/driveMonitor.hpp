@@ -0,0 +1,162 @@
+/**
+* ARSLab - Carleton University
+*
+* Drive Monitor:
+* Listens to the four LightBot motor ports and keeps summary metrics of the run instead of
+* writing every command: time spent in each DriveState, number of direction changes and
+* number of left/right steering flips. The metrics are written to a drive_metrics owned by
+* the caller, so they can be read after the runner returns.
+*/
+#ifndef SEEED_BOT_DRIVE_MONITOR_HPP
+#define SEEED_BOT_DRIVE_MONITOR_HPP
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "lightBot.hpp"
+#include "../utilities/time_conversion.hpp"
+
+struct drive_change {
+  long long time_us;
+  DriveState dir;
+};
+
+struct drive_metrics {
+  long long time_us[4];   // indexed by DriveState
+  long long now_us;       // time of the last motor command
+  unsigned long changes;  // DriveState changes
+  unsigned long flips;    // steering side reversals (left <-> right, straight in between allowed)
+  unsigned long commands; // motor port messages received
+  DriveState dir;
+  std::vector<drive_change>* history; // when set, every DriveState change is appended
+
+  drive_metrics() : time_us{0, 0, 0, 0}, now_us(0), changes(0), flips(0), commands(0), dir(DriveState::stop), history(nullptr) {}
+
+  // Accounts for the time between the last command and the end of the run.
+  void finish(long long end_us) {
+    if(end_us > now_us) {
+      time_us[(int) dir] += end_us - now_us;
+      now_us = end_us;
+    }
+  }
+};
+
+//Port definition
+    struct driveMonitor_defs {
+        //Input ports
+        struct rightMotor1 : public cadmium::in_port<float> { };
+        struct rightMotor2 : public cadmium::in_port<bool> { };
+        struct leftMotor1 : public cadmium::in_port<float> { };
+        struct leftMotor2 : public cadmium::in_port<bool> { };
+    };
+
+    template<typename TIME>
+    class DriveMonitor {
+        using defs=driveMonitor_defs; // putting definitions in context
+        public:
+            // default constructor
+            DriveMonitor() noexcept{
+              metrics = nullptr;
+              state.command = LightBot<TIME>::motorCommand(DriveState::stop);
+              state.steering = DriveState::straight;
+            }
+
+            DriveMonitor(drive_metrics* results) noexcept : DriveMonitor() {
+              metrics = results;
+            }
+
+            // state definition
+            struct state_type{
+              motor_command command;   // last value received on each motor port
+              DriveState steering;    // last side the bot turned to
+            };
+            state_type state;
+
+            // ports definition
+            using input_ports=std::tuple<typename defs::rightMotor1, typename defs::rightMotor2, typename defs::leftMotor1, typename defs::leftMotor2>;
+            using output_ports=std::tuple<>;
+
+            // internal transition
+            void internal_transition() {
+              throw std::logic_error("Internal transition called in a passive model");
+            }
+
+            // external transition
+            void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              if(!metrics) return;
+              metrics->time_us[(int) metrics->dir] += to_microseconds(e);
+              metrics->now_us += to_microseconds(e);
+
+              for(const auto &x : cadmium::get_messages<typename defs::rightMotor1>(mbs)){
+                state.command.rightMotor1 = x;
+                metrics->commands++;
+              }
+              for(const auto &x : cadmium::get_messages<typename defs::rightMotor2>(mbs)){
+                state.command.rightMotor2 = x;
+                metrics->commands++;
+              }
+              for(const auto &x : cadmium::get_messages<typename defs::leftMotor1>(mbs)){
+                state.command.leftMotor1 = x;
+                metrics->commands++;
+              }
+              for(const auto &x : cadmium::get_messages<typename defs::leftMotor2>(mbs)){
+                state.command.leftMotor2 = x;
+                metrics->commands++;
+              }
+
+              const DriveState dir = decode(state.command);
+              if(dir != metrics->dir) {
+                metrics->changes++;
+                metrics->dir = dir;
+                if(metrics->history) metrics->history->push_back({metrics->now_us, dir});
+              }
+              if(dir == DriveState::left || dir == DriveState::right) {
+                if(dir != state.steering && state.steering != DriveState::straight) {
+                  metrics->flips++;
+                }
+                state.steering = dir;
+              }
+            }
+
+            // confluence transition
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              external_transition(e, std::move(mbs));
+            }
+
+            // output function
+            typename cadmium::make_message_bags<output_ports>::type output() const {
+              typename cadmium::make_message_bags<output_ports>::type bags;
+              return bags;
+            }
+
+            // time_advance function
+            TIME time_advance() const {
+              return std::numeric_limits<TIME>::infinity();
+            }
+
+            friend std::ostringstream& operator<<(std::ostringstream& os, const typename DriveMonitor<TIME>::state_type& i) {
+              os << "Steering: " << (int) i.steering;
+              return os;
+            }
+
+        private:
+            // Finds the DriveState whose LightBot motor command matches the ports.
+            static DriveState decode(const motor_command& c) {
+              for(int d = (int) DriveState::right; d <= (int) DriveState::stop; d++) {
+                const motor_command expected = LightBot<TIME>::motorCommand((DriveState) d);
+                if(expected.rightMotor1 == c.rightMotor1 && expected.rightMotor2 == c.rightMotor2 &&
+                   expected.leftMotor1 == c.leftMotor1 && expected.leftMotor2 == c.leftMotor2) {
+                  return (DriveState) d;
+                }
+              }
+              return DriveState::stop;
+            }
+
+            drive_metrics* metrics;
+    };
+
+#endif // SEEED_BOT_DRIVE_MONITOR_HPP
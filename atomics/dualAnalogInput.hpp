@@ -0,0 +1,307 @@
+/**
+* ARSLab - Carleton University
+*
+* Dual Analog Input:
+* Reads the left and right light sensors together and sends them as one light_pair, so
+* LightBot compares two readings of the same instant and gets one event per sample instead
+* of two.
+*
+* RT_ARM_MBED: on STM32F4 (Nucleo-F401RE) both pins are converted in a single ADC1 scan
+* (SCAN mode, two-entry sequence) moved to memory by DMA2 Stream 0; the pins must be on
+* ADC1 channels, A4 (PC_1, IN11) and A5 (PC_0, IN10) are. Other targets and pins fall back
+* to two back-to-back AnalogIn reads. The pair is sampled every polling period. A scan that
+* does not complete in time is stopped and counted (light_pair_scanner::timeouts()), and
+* that pair is read with the AnalogIns instead, so stale DMA samples are never sent.
+*
+* Desktop: the two pin input files are replayed together. A pair is sent at every time
+* stamp found in either file, with the latest value of both channels.
+*/
+#ifndef SEEED_BOT_DUAL_ANALOG_INPUT_HPP
+#define SEEED_BOT_DUAL_ANALOG_INPUT_HPP
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#ifdef FIXED_MESSAGE_BAGS
+  #include "../data_structures/fixed_message_bag.hpp"
+#endif
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef RT_ARM_MBED
+  #include "mbed.h"
+#else
+  #include <cstdio>
+  #include <cstdlib>
+  #include <string>
+#endif
+
+#include "../data_structures/light_pair.hpp"
+#include "../utilities/time_conversion.hpp"
+
+//Port definition
+    struct dualAnalogInput_defs {
+        //Output ports
+        struct out : public cadmium::out_port<light_pair> { };
+    };
+
+#ifdef FIXED_MESSAGE_BAGS
+  FIXED_MESSAGE_BAG(dualAnalogInput_defs::out, FIXED_MESSAGE_BAG_CAPACITY)
+#endif
+
+#ifdef RT_ARM_MBED
+// Both channels of one light_pair. Not copyable: the DMA target must not move. The
+// AnalogIns read the pair on other targets, and when a scan times out.
+class light_pair_scanner {
+    public:
+        light_pair_scanner(PinName left, PinName right) : scan(false), leftIn(left), rightIn(right) {
+          #ifdef TARGET_STM32F4
+            const int leftChannel = adc1_channel(left);
+            const int rightChannel = adc1_channel(right);
+            if(leftChannel >= 0 && rightChannel >= 0) {
+              sequence = (uint32_t) leftChannel | ((uint32_t) rightChannel << 5);
+              sampling = (4U << (3 * (leftChannel - 10))) | (4U << (3 * (rightChannel - 10))); // 84 cycles
+              setup();
+              scan = true;
+            }
+          #endif
+        }
+
+        light_pair_scanner(const light_pair_scanner&) = delete;
+        light_pair_scanner& operator=(const light_pair_scanner&) = delete;
+
+        light_pair read() {
+          #ifdef TARGET_STM32F4
+            light_pair pair;
+            if(scan && scan_pair(pair)) {
+              return pair;
+            }
+          #endif
+          return {leftIn.read(), rightIn.read()};
+        }
+
+        // Scans that did not complete, of every scanner.
+        static unsigned long& timeouts() {
+          static unsigned long count = 0;
+          return count;
+        }
+
+    private:
+        #ifdef TARGET_STM32F4
+          // ADC1 input channel of a pin, -1 if the scan does not support it.
+          static int adc1_channel(PinName pin) {
+            if(pin == PC_0) return 10;
+            if(pin == PC_1) return 11;
+            return -1;
+          }
+
+          void setup() {
+            RCC->AHB1ENR |= RCC_AHB1ENR_GPIOCEN | RCC_AHB1ENR_DMA2EN;
+            RCC->APB2ENR |= RCC_APB2ENR_ADC1EN;
+            GPIOC->MODER |= (3U << (0 * 2)) | (3U << (1 * 2)); // PC0, PC1 analog
+            ADC->CCR = (ADC->CCR & ~ADC_CCR_ADCPRE) | ADC_CCR_ADCPRE_0; // ADC clock: PCLK2 / 4
+
+            DMA2_Stream0->CR = 0;
+            while(DMA2_Stream0->CR & DMA_SxCR_EN) {}
+            DMA2_Stream0->PAR = (uint32_t) &ADC1->DR;
+            DMA2_Stream0->M0AR = (uint32_t) samples;
+            // Channel 0 (ADC1), peripheral to memory, 16-bit both sides, memory increment.
+            DMA2_Stream0->CR = DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC | DMA_SxCR_PL_1;
+          }
+
+          // One two-conversion scan (about 10 us). The ADC setup is written every time,
+          // so an AnalogIn using ADC1 (the fallback ones too) does not break the scan.
+          // False if the DMA did not complete: the stream and the ADC DMA requests are
+          // stopped and the samples are left unused.
+          bool scan_pair(light_pair& pair) {
+            DMA2->LIFCR = DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0;
+            DMA2_Stream0->NDTR = 2;
+            DMA2_Stream0->CR |= DMA_SxCR_EN;
+
+            ADC1->CR1 = ADC_CR1_SCAN;
+            ADC1->SMPR1 = (ADC1->SMPR1 & ~(ADC_SMPR1_SMP10 | ADC_SMPR1_SMP11)) | sampling;
+            ADC1->SQR1 = ADC_SQR1_L_0; // two conversions
+            ADC1->SQR3 = sequence;
+            ADC1->SR = 0;
+            ADC1->CR2 = ADC_CR2_ADON; // also clears DMA, re-armed below for this scan
+            ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_DMA;
+            ADC1->CR2 |= ADC_CR2_SWSTART;
+
+            for(int spin = 0; !(DMA2->LISR & DMA_LISR_TCIF0); spin++) {
+              if(spin == 100000) {
+                DMA2_Stream0->CR &= ~DMA_SxCR_EN;
+                ADC1->CR2 = ADC_CR2_ADON;
+                timeouts()++;
+                return false;
+              }
+            }
+            pair = {samples[0] / 4095.0f, samples[1] / 4095.0f};
+            return true;
+          }
+
+          uint32_t sequence;
+          uint32_t sampling;
+          volatile uint16_t samples[2]; // left, right
+        #endif
+
+        bool scan;
+        mbed::AnalogIn leftIn;
+        mbed::AnalogIn rightIn;
+};
+#else
+// Replays two pin input files ("HH:MM:SS:mmm value" lines) as one stream of pairs.
+class light_pair_replay {
+    public:
+        light_pair_replay(const char* left_path, const char* right_path) : pair{0, 0} {
+          open(0, left_path);
+          open(1, right_path);
+        }
+
+        ~light_pair_replay() {
+          for(FILE* f : files) if(f) std::fclose(f);
+        }
+
+        light_pair_replay(const light_pair_replay&) = delete;
+        light_pair_replay& operator=(const light_pair_replay&) = delete;
+
+        // Time of the next pair and both channel values at that time. False when both files ended.
+        bool next(long long& time_us, light_pair& value) {
+          if(!pending[0] && !pending[1]) return false;
+          time_us = !pending[0] ? times[1] : !pending[1] ? times[0] : (times[0] < times[1] ? times[0] : times[1]);
+          for(int c = 0; c < 2; c++) {
+            if(pending[c] && times[c] == time_us) {
+              (c == 0 ? pair.left : pair.right) = values[c];
+              advance(c);
+            }
+          }
+          value = pair;
+          return true;
+        }
+
+    private:
+        void open(int c, const char* path) {
+          files[c] = std::fopen(path, "r");
+          if(!files[c]) throw std::runtime_error(std::string("Cannot open pin input file ") + path);
+          advance(c);
+        }
+
+        void advance(int c) {
+          char line[128];
+          pending[c] = false;
+          while(std::fgets(line, sizeof(line), files[c])) {
+            const char* value;
+            if(parse_time_string(line, times[c], &value)) {
+              values[c] = std::strtof(value, nullptr);
+              pending[c] = true;
+              return;
+            }
+          }
+        }
+
+        FILE* files[2];
+        long long times[2];
+        float values[2];
+        bool pending[2];
+        light_pair pair;
+};
+#endif
+
+    template<typename TIME>
+    class DualAnalogInput {
+        using defs=dualAnalogInput_defs; // putting definitions in context
+        public:
+            // default constructor
+            DualAnalogInput() noexcept{
+              state.output = {0, 0};
+              state.last_us = 0;
+              state.next_us = 0;
+              state.done = true;
+              #ifdef RT_ARM_MBED
+                period_us = 100000;
+              #endif
+            }
+
+            #ifdef RT_ARM_MBED
+              DualAnalogInput(PinName left, PinName right, long long polling_us = 100000) : DualAnalogInput() {
+                scanner = std::make_shared<light_pair_scanner>(left, right);
+                period_us = polling_us;
+                state.output = scanner->read();
+                state.done = false;
+              }
+            #else
+              DualAnalogInput(const char* left_path, const char* right_path) : DualAnalogInput() {
+                replay = std::make_shared<light_pair_replay>(left_path, right_path);
+                state.done = !replay->next(state.next_us, state.output);
+              }
+            #endif
+
+            // state definition
+            struct state_type{
+              light_pair output; // pair sent at the next internal event
+              long long last_us; // time of the last pair sent (desktop)
+              long long next_us; // time of the next pair (desktop)
+              bool done;
+            };
+            state_type state;
+
+            // ports definition
+            using input_ports=std::tuple<>;
+            using output_ports=std::tuple<typename defs::out>;
+
+            // internal transition
+            void internal_transition() {
+              #ifdef RT_ARM_MBED
+                state.output = scanner->read();
+              #else
+                state.last_us = state.next_us;
+                state.done = !replay->next(state.next_us, state.output);
+              #endif
+            }
+
+            // external transition
+            void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              throw std::logic_error("External transition called in a model with no input ports");
+            }
+
+            // confluence transition
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              internal_transition();
+              external_transition(TIME(), std::move(mbs));
+            }
+
+            // output function
+            typename cadmium::make_message_bags<output_ports>::type output() const {
+              typename cadmium::make_message_bags<output_ports>::type bags;
+              cadmium::get_messages<typename defs::out>(bags).push_back(state.output);
+              return bags;
+            }
+
+            // time_advance function
+            TIME time_advance() const {
+              if(state.done) {
+                return std::numeric_limits<TIME>::infinity();
+              }
+              #ifdef RT_ARM_MBED
+                return from_microseconds<TIME>(period_us);
+              #else
+                return from_microseconds<TIME>(state.next_us - state.last_us);
+              #endif
+            }
+
+            friend std::ostringstream& operator<<(std::ostringstream& os, const typename DualAnalogInput<TIME>::state_type& i) {
+              os << "Left: " << i.output.left << " Right: " << i.output.right;
+              return os;
+            }
+
+        private:
+            #ifdef RT_ARM_MBED
+              std::shared_ptr<light_pair_scanner> scanner;
+              long long period_us;
+            #else
+              std::shared_ptr<light_pair_replay> replay;
+            #endif
+    };
+
+#endif // SEEED_BOT_DUAL_ANALOG_INPUT_HPP
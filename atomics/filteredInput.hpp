@@ -0,0 +1,177 @@
+/**
+* ARSLab - Carleton University
+*
+* Filtered Input:
+* Decorator for the analog input models that drops samples which do not need an event:
+*   deadband    a sample is sent only if it differs from the last sent value by at least this much
+*   decimation  at most one sample in N is sent (1 = no limit)
+*   period      minimum time between two sent samples (0 = no limit)
+* The first sample is always sent. The deadband is measured from the last value sent, so a
+* slow drift is still sent once it adds up to the deadband.
+*
+* Each sample is decided once, in output(), which calls the decorated model's output() once;
+* the decision is kept for the internal transition that follows.
+*
+* A deadband can change the steering: LightBot compares the two light readings with a 0.1
+* threshold, and a per-pin deadband of d can hide up to 2 * d of their difference. main.cpp
+* uses no_input_filter; check a setting with FILTER_REPORT before turning it on.
+*
+*   const input_filter lightFilter = {0.01, 1, 0};
+*   make_dynamic_atomic_model<filtered_input<AnalogInput>::model, TIME>("rightLightSens", instrumentation{"rightLightSens", {}, lightFilter}, A5);
+*
+* Every filtered pin counts its samples and sent events under its name; input_filter_stats::report()
+* prints them. On desktop, load_input_filters() reads the settings from a text file instead.
+*/
+#ifndef SEEED_BOT_FILTERED_INPUT_HPP
+#define SEEED_BOT_FILTERED_INPUT_HPP
+
+#include <cadmium/modeling/message_bag.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+#include <utility>
+
+#include "../utilities/instrumentation.hpp"
+#include "../utilities/named_registry.hpp"
+#include "../utilities/time_conversion.hpp"
+
+#ifndef INPUT_FILTER_PINS
+  #define INPUT_FILTER_PINS 8
+#endif
+
+// Change between two samples compared with the deadband. Message types other than float
+// provide their own overload (data_structures/light_pair.hpp).
+inline float filter_distance(float a, float b) {
+  return std::fabs(a - b);
+}
+
+struct input_filter_stats {
+  unsigned long samples = 0; // samples produced by the input model
+  unsigned long sent = 0;    // samples sent on to the controller
+
+  // Counters registered under name, created on first use. nullptr when all slots are taken.
+  static input_filter_stats* get(const char* name) {
+    return registry().get(name);
+  }
+
+  static void report(FILE* out) {
+    registry().for_each([&](const char* name, const input_filter_stats& e) {
+      std::fprintf(out, "%-16s samples %10lu  sent %10lu  (%.1f%%)\n", name, e.samples, e.sent,
+                   e.samples ? 100.0 * e.sent / e.samples : 0.0);
+    });
+  }
+
+  static void reset() {
+    registry().for_each([](const char*, input_filter_stats& e) { e = input_filter_stats(); });
+  }
+
+  private:
+    static NamedRegistry<input_filter_stats, INPUT_FILTER_PINS>& registry() {
+      static NamedRegistry<input_filter_stats, INPUT_FILTER_PINS> stats;
+      return stats;
+    }
+};
+
+#ifndef RT_ARM_MBED
+// Reads "name deadband decimation period_us" lines ('#' starts a comment) and sets filter
+// to the line for name. Returns false, leaving filter unchanged, if there is no such line.
+inline bool load_input_filters(const char* path, const char* name, input_filter& filter) {
+  FILE* file = std::fopen(path, "r");
+  if(!file) return false;
+  char line[256];
+  bool found = false;
+  while(std::fgets(line, sizeof(line), file)) {
+    char pin[64];
+    float deadband;
+    unsigned decimation;
+    long long period_us;
+    if(line[0] == '#') continue;
+    if(std::sscanf(line, "%63s %f %u %lld", pin, &deadband, &decimation, &period_us) == 4 && std::strcmp(pin, name) == 0) {
+      filter = {deadband, decimation > 0 ? decimation : 1, period_us};
+      found = true;
+    }
+  }
+  std::fclose(file);
+  return found;
+}
+#endif
+
+template<template<typename> class MODEL>
+struct filtered_input {
+    template<typename TIME>
+    class model : public decorator_base<MODEL<TIME>> {
+        using base=MODEL<TIME>;
+        using out_port=typename std::tuple_element<0, typename base::output_ports>::type;
+        using value_type=typename out_port::message_type;
+        public:
+            model() : decorator_base<base>(), filter(no_input_filter), stats(nullptr), sample(false), pass(false) {
+              reset();
+            }
+
+            template<typename... ARGs>
+            model(const instrumentation& config, ARGs&&... args) : decorator_base<base>(config, std::forward<ARGs>(args)...), filter(config.filter), stats(nullptr), sample(false), pass(false) {
+              reset();
+              if(filter.decimation == 0) filter.decimation = 1;
+              stats = input_filter_stats::get(config.name);
+            }
+
+            // Applies the decision output() made for this sample.
+            void internal_transition() {
+              since_us += to_microseconds(base::time_advance());
+              if(sample) {
+                if(stats) stats->samples++;
+                if(pass) {
+                  last = value;
+                  primed = true;
+                  since_us = 0;
+                  skipped = 0;
+                  if(stats) stats->sent++;
+                } else {
+                  skipped++;
+                }
+              }
+              sample = false;
+              base::internal_transition();
+            }
+
+            typename cadmium::make_message_bags<typename base::output_ports>::type output() const {
+              auto bags = base::output();
+              auto& messages = cadmium::get_messages<out_port>(bags);
+              sample = !messages.empty();
+              if(sample) {
+                value = messages.back();
+                pass = passes(value);
+                if(!pass) messages.clear();
+              }
+              return bags;
+            }
+
+        private:
+            bool passes(const value_type& value) const {
+              if(!primed) return true;
+              if(skipped + 1 < filter.decimation) return false;
+              if(since_us < filter.period_us) return false;
+              return filter_distance(value, last) >= filter.deadband;
+            }
+
+            void reset() {
+              last = value_type();
+              primed = false;
+              since_us = 0;
+              skipped = 0;
+            }
+
+            input_filter filter;
+            input_filter_stats* stats;
+            value_type last;        // last value sent
+            bool primed;            // false until the first sample is sent
+            long long since_us;     // time since the last sample sent
+            unsigned skipped;       // samples dropped since the last one sent
+            mutable bool sample;          // the last output() had a sample
+            mutable bool pass;            // and it was sent
+            mutable value_type value;     // its value
+    };
+};
+
+#endif // SEEED_BOT_FILTERED_INPUT_HPP
@@ -0,0 +1,221 @@
+/**
+* ARSLab - Carleton University
+*
+* Golden Output:
+* Stands in for an output pin model during replay: instead of writing the pin file, every
+* value received is checked against a reference pin file (the checked-in outputs/). Both are
+* compared as step functions, the value a pin holds at each instant, so a run that only sends
+* changes still matches a reference written on every command. The checks go to a
+* golden_pin_check owned by the caller, which keeps the first divergence.
+*
+*   golden_pin_check d11("D11", "outputs/D11_RightMotor2_Out.txt");
+*   make_dynamic_atomic_model<GoldenPwmOutput, TIME>("rightMotor1", &d11);
+*   ... run ...
+*   d11.finish(to_microseconds(until));
+*/
+#ifndef SEEED_BOT_GOLDEN_OUTPUT_HPP
+#define SEEED_BOT_GOLDEN_OUTPUT_HPP
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../utilities/time_conversion.hpp"
+
+// Comparison of one pin against its reference file, fed in time order.
+class golden_pin_check {
+    public:
+        golden_pin_check(const char* pin_name, const char* golden_path, float tolerance = 1e-4f)
+          : name(pin_name), tolerance(tolerance), actual(0), expected(0), divergence_us(-1),
+            divergent_expected(0), divergent_actual(0), checks(0), mismatches(0) {
+          file = std::fopen(golden_path, "r");
+          if(!file) throw std::runtime_error(std::string("Cannot open golden file ") + golden_path);
+          read_next();
+        }
+
+        ~golden_pin_check() {
+          if(file) std::fclose(file);
+        }
+
+        golden_pin_check(const golden_pin_check&) = delete;
+        golden_pin_check& operator=(const golden_pin_check&) = delete;
+
+        // The pin took value at time_us.
+        void observe(long long time_us, float value) {
+          advance(time_us, false);
+          actual = value;
+          compare(time_us);
+        }
+
+        // Checks the reference changes left up to the end of the run.
+        void finish(long long end_us) {
+          advance(end_us, true);
+        }
+
+        bool diverged() const { return divergence_us >= 0; }
+        long long first_divergence_us() const { return divergence_us; }
+
+        void report(FILE* out) const {
+          if(!diverged()) {
+            std::fprintf(out, "%-4s match         (%lu checks)\n", name, checks);
+          } else {
+            std::fprintf(out, "%-4s DIVERGES at %s: expected %g, got %g  (%lu of %lu checks differ)\n", name,
+                         format_time_string(divergence_us).c_str(), divergent_expected, divergent_actual, mismatches, checks);
+          }
+        }
+
+    private:
+        // Applies the reference changes before time_us, comparing each, then the ones at time_us.
+        // Those are only compared here when inclusive, otherwise observe() compares them with
+        // the actual value of the same instant.
+        void advance(long long time_us, bool inclusive) {
+          while(pending && next_us < time_us) {
+            expected = next_value;
+            const long long at = next_us;
+            read_next();
+            if(!pending || next_us != at) compare(at);
+          }
+          bool changed = false;
+          while(pending && next_us == time_us) {
+            expected = next_value;
+            read_next();
+            changed = true;
+          }
+          if(changed && inclusive) compare(time_us);
+        }
+
+        void compare(long long time_us) {
+          checks++;
+          if(std::fabs(actual - expected) > tolerance) {
+            mismatches++;
+            if(divergence_us < 0) {
+              divergence_us = time_us;
+              divergent_expected = expected;
+              divergent_actual = actual;
+            }
+          }
+        }
+
+        void read_next() {
+          char line[128];
+          pending = false;
+          while(std::fgets(line, sizeof(line), file)) {
+            const char* value;
+            if(parse_time_string(line, next_us, &value)) {
+              next_value = std::strtof(value, nullptr);
+              pending = true;
+              return;
+            }
+          }
+        }
+
+        const char* name;
+        float tolerance;
+        FILE* file;
+        bool pending;         // next_us/next_value hold a reference change not applied yet
+        long long next_us;
+        float next_value;
+        float actual;         // pin value now
+        float expected;       // reference value now
+        long long divergence_us;
+        float divergent_expected;
+        float divergent_actual;
+        unsigned long checks;
+        unsigned long mismatches;
+};
+
+//Port definition
+    struct goldenPwmOutput_defs {
+        struct in : public cadmium::in_port<float> { };
+    };
+
+    struct goldenDigitalOutput_defs {
+        struct in : public cadmium::in_port<bool> { };
+    };
+
+    template<typename VALUE, typename TIME, typename DEFS>
+    class golden_output {
+        using defs=DEFS; // putting definitions in context
+        public:
+            // default constructor
+            golden_output() noexcept{
+              check = nullptr;
+              state.now_us = 0;
+              state.value = 0;
+            }
+
+            golden_output(golden_pin_check* pin) noexcept : golden_output() {
+              check = pin;
+            }
+
+            // state definition
+            struct state_type{
+              long long now_us; // time of the last value received
+              VALUE value;
+            };
+            state_type state;
+
+            // ports definition
+            using input_ports=std::tuple<typename defs::in>;
+            using output_ports=std::tuple<>;
+
+            // internal transition
+            void internal_transition() {
+              throw std::logic_error("Internal transition called in a passive model");
+            }
+
+            // external transition
+            void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              state.now_us += to_microseconds(e);
+              const auto& messages = cadmium::get_messages<typename defs::in>(mbs);
+              if(messages.empty()) return;
+              state.value = messages.back();
+              if(check) check->observe(state.now_us, (float) state.value);
+            }
+
+            // confluence transition
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              external_transition(e, std::move(mbs));
+            }
+
+            // output function
+            typename cadmium::make_message_bags<output_ports>::type output() const {
+              typename cadmium::make_message_bags<output_ports>::type bags;
+              return bags;
+            }
+
+            // time_advance function
+            TIME time_advance() const {
+              return std::numeric_limits<TIME>::infinity();
+            }
+
+            friend std::ostringstream& operator<<(std::ostringstream& os, const typename golden_output<VALUE, TIME, DEFS>::state_type& i) {
+              os << "Pin: " << i.value;
+              return os;
+            }
+
+        private:
+            golden_pin_check* check;
+    };
+
+    template<typename TIME>
+    class GoldenPwmOutput : public golden_output<float, TIME, goldenPwmOutput_defs> {
+        public:
+            GoldenPwmOutput() = default;
+            GoldenPwmOutput(golden_pin_check* pin) : golden_output<float, TIME, goldenPwmOutput_defs>(pin) {}
+    };
+
+    template<typename TIME>
+    class GoldenDigitalOutput : public golden_output<bool, TIME, goldenDigitalOutput_defs> {
+        public:
+            GoldenDigitalOutput() = default;
+            GoldenDigitalOutput(golden_pin_check* pin) : golden_output<bool, TIME, goldenDigitalOutput_defs>(pin) {}
+    };
+
+#endif // SEEED_BOT_GOLDEN_OUTPUT_HPP
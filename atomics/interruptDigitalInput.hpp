@@ -0,0 +1,415 @@
+/**
+* ARSLab - Carleton University
+*
+* Interrupt Digital Input:
+* Glitch-latching variant of the polled DigitalInput, for pins whose short pulses must not be
+* missed (the center IR cliff sensor). It uses the digitalInput_defs port, so the couplings do
+* not change. It is still a polled input: it does not wake the runner on an edge.
+*
+* RT_ARM_MBED: an mbed::InterruptIn latches the pin level and counts the edges. The Cadmium
+* real-time clock waits out each time advance and cannot be cut short from an interrupt, so
+* the model checks the latch every INTERRUPT_INPUT_WATCHDOG_MS (100 ms by default, the period
+* of the polled DigitalInput) and sends a new level at once. The stop latency and the wake-ups
+* are those of polling at the same period; what the latch adds is that a change shorter than
+* the period is not lost: when the level is back to the one last sent but there were edges in
+* between, the other level is sent and held until the next check, then the current one.
+* The interrupt also stamps the first edge after each check with the cycle clock, and
+* sample_stamp() hands it to latency_source, so latencies count from the edge itself.
+*
+* Desktop: the edges come from a pin_edge_queue, loaded from a pin input file or filled by
+* the caller. With a check period the queue is read at every check, as the latch is on target
+* (irq_report.cpp uses this). With no period (0, the default) the model is scheduled exactly at
+* each edge, to replay a trace. PolledDigitalInput samples the same queue at a fixed period,
+* the way DigitalInput reads the pin on target, so both can be compared.
+*
+* Both count their wake-ups and pin edges in an optional digital_input_stats.
+*/
+#ifndef SEEED_BOT_INTERRUPT_DIGITAL_INPUT_HPP
+#define SEEED_BOT_INTERRUPT_DIGITAL_INPUT_HPP
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cadmium/real_time/arm_mbed/io/digitalInput.hpp>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef RT_ARM_MBED
+  #include "mbed.h"
+#else
+  #include <cstdio>
+  #include <cstdlib>
+  #include <string>
+  #include <vector>
+#endif
+
+#include "../utilities/cycle_clock.hpp"
+#include "../utilities/time_conversion.hpp"
+
+#ifndef INTERRUPT_INPUT_WATCHDOG_MS
+  #define INTERRUPT_INPUT_WATCHDOG_MS 100
+#endif
+
+struct digital_input_stats {
+  unsigned long wakeups; // internal transitions: each one is a pin read or a latch check
+  unsigned long edges;   // pin level changes seen by the interrupt (or in the queue)
+  unsigned long sent;    // values sent to the controller
+
+  digital_input_stats() : wakeups(0), edges(0), sent(0) {}
+};
+
+#ifdef RT_ARM_MBED
+// Interrupt side of InterruptDigitalInput. Not copyable: the InterruptIn callbacks point to
+// it. The copies of the model share it.
+class pin_edge_latch {
+    public:
+        explicit pin_edge_latch(PinName pin) : input(pin), edges(0), first_edge(0) {
+          cycle_clock::init();
+          level = input.read() == 1;
+          input.rise(mbed::callback(this, &pin_edge_latch::rise));
+          input.fall(mbed::callback(this, &pin_edge_latch::fall));
+        }
+
+        pin_edge_latch(const pin_edge_latch&) = delete;
+        pin_edge_latch& operator=(const pin_edge_latch&) = delete;
+
+        // Level, edge count and the time of the first edge since the last snapshot (0 if
+        // none), read together.
+        void snapshot(bool& pin_level, uint32_t& edge_count, cycle_clock::ticks& edge_time) {
+          core_util_critical_section_enter();
+          pin_level = level;
+          edge_count = edges;
+          edge_time = first_edge;
+          first_edge = 0;
+          core_util_critical_section_exit();
+        }
+
+    private:
+        void rise() { edge(true); }
+        void fall() { edge(false); }
+
+        void edge(bool new_level) {
+          if(first_edge == 0) first_edge = cycle_clock::now() | 1;
+          level = new_level;
+          edges++;
+        }
+
+        mbed::InterruptIn input;
+        volatile bool level;
+        volatile uint32_t edges;
+        volatile cycle_clock::ticks first_edge;
+};
+#else
+// Pin edges in time order, consumed by one model. Edges are pushed before the run.
+class pin_edge_queue {
+    public:
+        struct edge {
+          long long time_us;
+          bool level;
+        };
+
+        pin_edge_queue() : next(0), initial(false) {}
+
+        // Reads a pin input file ("HH:MM:SS:mmm value" lines). The value at time 0, if any,
+        // is the initial level.
+        explicit pin_edge_queue(const char* file_path) : pin_edge_queue() {
+          FILE* file = std::fopen(file_path, "r");
+          if(!file) throw std::runtime_error(std::string("Cannot open pin input file ") + file_path);
+          char line[128];
+          while(std::fgets(line, sizeof(line), file)) {
+            long long time_us;
+            const char* value;
+            if(parse_time_string(line, time_us, &value)) {
+              push(time_us, std::strtol(value, nullptr, 10) != 0);
+            }
+          }
+          std::fclose(file);
+        }
+
+        // Levels equal to the current one are not edges and are dropped.
+        void push(long long time_us, bool level) {
+          const bool current = edges.empty() ? initial : edges.back().level;
+          if(time_us <= 0 && edges.empty()) {
+            initial = level;
+          } else if(level != current) {
+            edges.push_back({time_us, level});
+          }
+        }
+
+        bool initial_level() const { return initial; }
+        bool empty() const { return next == edges.size(); }
+        const edge& front() const { return edges[next]; }
+        void pop() { next++; }
+
+    private:
+        std::vector<edge> edges;
+        std::size_t next;
+        bool initial;
+};
+#endif
+
+    template<typename TIME>
+    class InterruptDigitalInput {
+        using defs=digitalInput_defs; // putting definitions in context
+        public:
+            // default constructor
+            InterruptDigitalInput() noexcept{
+              stats = nullptr;
+              check_us = 0;
+              #ifdef RT_ARM_MBED
+                latch = nullptr;
+              #else
+                pin = false;
+                edge_count = 0;
+              #endif
+              state.output = false;
+              state.last = false;
+              state.held = false;
+              state.now_us = 0;
+              state.seen = 0;
+              state.edge_time = 0;
+            }
+
+            #ifdef RT_ARM_MBED
+              InterruptDigitalInput(PinName pin, digital_input_stats* counters = nullptr) : InterruptDigitalInput() {
+                stats = counters;
+                check_us = INTERRUPT_INPUT_WATCHDOG_MS * 1000LL;
+                latch = std::make_shared<pin_edge_latch>(pin);
+                latch->snapshot(state.output, state.seen, state.edge_time);
+                state.last = !state.output; // the initial level is sent at time 0
+              }
+            #else
+              // check_period_us = 0: scheduled at each edge of the trace.
+              InterruptDigitalInput(const char* file_path, digital_input_stats* counters = nullptr, long long check_period_us = 0)
+                : InterruptDigitalInput(std::make_shared<pin_edge_queue>(file_path), counters, check_period_us) {}
+
+              InterruptDigitalInput(std::shared_ptr<pin_edge_queue> edges, digital_input_stats* counters = nullptr, long long check_period_us = 0) : InterruptDigitalInput() {
+                stats = counters;
+                check_us = check_period_us;
+                queue = edges;
+                pin = queue->initial_level();
+                state.output = pin;
+                state.last = !state.output;
+              }
+            #endif
+
+            // state definition
+            struct state_type{
+              bool output;      // level to send
+              bool last;        // last level sent
+              bool held;        // a latched change was just sent, the pin is read at the next check
+              long long now_us; // simulated time of the last transition (desktop)
+              uint32_t seen;    // edge count at the last check
+              cycle_clock::ticks edge_time; // cycle clock at the first edge of the level to send (RT_ARM_MBED)
+            };
+            state_type state;
+
+            // ports definition
+            using input_ports=std::tuple<>;
+            using output_ports=std::tuple<typename defs::out>;
+
+            // internal transition
+            void internal_transition() {
+              const bool sent = state.output != state.last;
+              state.now_us += to_microseconds(time_advance());
+              state.last = state.output;
+              if(stats) {
+                stats->wakeups++;
+                if(sent) stats->sent++;
+              }
+              if(state.held) {
+                state.held = false;
+                return;
+              }
+              bool level;
+              uint32_t edges;
+              if(!read(level, edges)) return;
+              if(stats) stats->edges += edges - state.seen;
+              const bool changed = edges != state.seen;
+              state.seen = edges;
+              state.output = level;
+              // Edges but the same level as last sent: the pin changed and came back between
+              // two checks. The change is sent anyway and held for one check period.
+              if(changed && level == state.last && check_us > 0) {
+                state.output = !state.last;
+                state.held = true;
+              }
+            }
+
+            // external transition
+            void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              throw std::logic_error("External transition called in a model with no input ports");
+            }
+
+            // confluence transition
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              internal_transition();
+              external_transition(TIME(), std::move(mbs));
+            }
+
+            // output function
+            typename cadmium::make_message_bags<output_ports>::type output() const {
+              typename cadmium::make_message_bags<output_ports>::type bags;
+              if(state.output != state.last) {
+                cadmium::get_messages<typename defs::out>(bags).push_back(state.output);
+              }
+              return bags;
+            }
+
+            // Cycle clock time of the edge being sent, 0 when it is not known (latency_source).
+            cycle_clock::ticks sample_stamp() const {
+              return state.output != state.last ? state.edge_time : 0;
+            }
+
+            // time_advance function
+            TIME time_advance() const {
+              if(state.output != state.last) {
+                return TIME();
+              }
+              #ifdef RT_ARM_MBED
+                if(!latch) {
+                  return std::numeric_limits<TIME>::infinity();
+                }
+              #else
+                if(!queue || (check_us == 0 && queue->empty())) {
+                  return std::numeric_limits<TIME>::infinity();
+                }
+                if(check_us == 0) {
+                  return from_microseconds<TIME>(queue->front().time_us - state.now_us);
+                }
+              #endif
+              return from_microseconds<TIME>(check_us);
+            }
+
+            friend std::ostringstream& operator<<(std::ostringstream& os, const typename InterruptDigitalInput<TIME>::state_type& i) {
+              os << "Pin: " << (i.output ? 1 : 0);
+              return os;
+            }
+
+        private:
+            // Pin level and total edge count now: the latch on target, the queue up to now on desktop.
+            bool read(bool& level, uint32_t& edges) {
+              #ifdef RT_ARM_MBED
+                if(!latch) return false;
+                latch->snapshot(level, edges, state.edge_time);
+              #else
+                if(!queue) return false;
+                while(!queue->empty() && queue->front().time_us <= state.now_us) {
+                  pin = queue->front().level;
+                  queue->pop();
+                  edge_count++;
+                }
+                level = pin;
+                edges = edge_count;
+              #endif
+              return true;
+            }
+
+            digital_input_stats* stats;
+            long long check_us; // latch check period, 0 to follow the edges (desktop)
+            #ifdef RT_ARM_MBED
+              std::shared_ptr<pin_edge_latch> latch;
+            #else
+              std::shared_ptr<pin_edge_queue> queue;
+              bool pin;            // level of the last edge taken from the queue
+              uint32_t edge_count; // edges taken from the queue
+            #endif
+    };
+
+#ifndef RT_ARM_MBED
+    // Reads a pin_edge_queue every period and sends the level when it changed, like the
+    // polled DigitalInput on target. Edges shorter than the period can be missed.
+    template<typename TIME>
+    class PolledDigitalInput {
+        using defs=digitalInput_defs; // putting definitions in context
+        public:
+            // default constructor
+            PolledDigitalInput() noexcept{
+              stats = nullptr;
+              period_us = 100000;
+              state.output = false;
+              state.last = false;
+              state.now_us = 0;
+            }
+
+            PolledDigitalInput(std::shared_ptr<pin_edge_queue> edges, long long period, digital_input_stats* counters = nullptr) : PolledDigitalInput() {
+              stats = counters;
+              queue = edges;
+              period_us = period;
+              state.output = queue->initial_level();
+              state.last = !state.output;
+            }
+
+            // state definition
+            struct state_type{
+              bool output;      // level read at the last poll
+              bool last;        // last level sent
+              long long now_us; // simulated time of the last poll
+            };
+            state_type state;
+
+            // ports definition
+            using input_ports=std::tuple<>;
+            using output_ports=std::tuple<typename defs::out>;
+
+            // internal transition
+            void internal_transition() {
+              if(stats) {
+                stats->wakeups++;
+                if(state.output != state.last) stats->sent++;
+              }
+              state.now_us += to_microseconds(time_advance());
+              state.last = state.output;
+              while(queue && !queue->empty() && queue->front().time_us <= state.now_us) {
+                state.output = queue->front().level;
+                queue->pop();
+                if(stats) stats->edges++;
+              }
+            }
+
+            // external transition
+            void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              throw std::logic_error("External transition called in a model with no input ports");
+            }
+
+            // confluence transition
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              internal_transition();
+              external_transition(TIME(), std::move(mbs));
+            }
+
+            // output function
+            typename cadmium::make_message_bags<output_ports>::type output() const {
+              typename cadmium::make_message_bags<output_ports>::type bags;
+              if(state.output != state.last) {
+                cadmium::get_messages<typename defs::out>(bags).push_back(state.output);
+              }
+              return bags;
+            }
+
+            // time_advance function
+            TIME time_advance() const {
+              if(!queue) {
+                return std::numeric_limits<TIME>::infinity();
+              }
+              if(state.output != state.last) {
+                return TIME(); // a change read at the last poll is sent at once
+              }
+              return from_microseconds<TIME>(period_us);
+            }
+
+            friend std::ostringstream& operator<<(std::ostringstream& os, const typename PolledDigitalInput<TIME>::state_type& i) {
+              os << "Pin: " << (i.output ? 1 : 0);
+              return os;
+            }
+
+        private:
+            digital_input_stats* stats;
+            std::shared_ptr<pin_edge_queue> queue;
+            long long period_us;
+    };
+#endif
+
+#endif // SEEED_BOT_INTERRUPT_DIGITAL_INPUT_HPP
@@ -0,0 +1,294 @@
+/**
+* ARSLab - Carleton University
+*
+* Latency Probe:
+* Decorators that measure the end-to-end time between a sensor event and the matching motor
+* command, without changing any port. Define LATENCY_PROBES to turn them on; otherwise they
+* are plain pass-throughs to the decorated model.
+*
+*   latency_source<M>  input models: stamps every sample it sends with the time of the event.
+*   latency_relay<M>   controller: keeps the oldest stamp of the inputs it has not answered yet
+*                      and hands it to the outputs it sends next.
+*   latency_sink<M>    output models: records now - stamp in a histogram named after the model.
+*
+*   make_dynamic_atomic_model<latency_source<DigitalInput>::model, TIME>("centerIR", instrumentation{"centerIR"}, A2);
+*   make_dynamic_atomic_model<latency_relay<LightBot>::model, TIME>("lightBot", instrumentation{"lightBot"});
+*   make_dynamic_atomic_model<latency_sink<PwmOutput>::model, TIME>("rightMotor1", instrumentation{"rightMotor1"}, D11);
+*
+* The stamp of a sample is the time of the event, not the time the model got around to send it:
+* the interrupt time of the edge for models that record one (sample_stamp(), see
+* InterruptDigitalInput), otherwise the scheduled time of the sample on the clock started by
+* latency_probe::start() (RT_ARM_MBED). On desktop the simulation runs ahead of the wall clock,
+* so samples are stamped when they are sent and the numbers are the processing time only.
+* Stamps travel with the samples: every sample sent in a step is queued, and the controller
+* takes them all in its transition, so inputs arriving together do not overwrite each other.
+*
+* latency_probe::report() prints every histogram (min/p50/p99/max). The histogram buckets are
+* 1/8 of a power of two wide and a percentile is the upper bound of its bucket, so percentiles
+* read up to 12.5% high: 100000 latencies spread evenly over 1-100 us report p50 = 53 us.
+* min and max are exact.
+*/
+#ifndef SEEED_BOT_LATENCY_PROBE_HPP
+#define SEEED_BOT_LATENCY_PROBE_HPP
+
+#include <cadmium/modeling/message_bag.hpp>
+#include <cstdio>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "../utilities/cycle_clock.hpp"
+#include "../utilities/instrumentation.hpp"
+#include "../utilities/latency_histogram.hpp"
+#include "../utilities/named_registry.hpp"
+#include "../utilities/time_conversion.hpp"
+
+#ifndef LATENCY_PROBE_HISTOGRAMS
+  #define LATENCY_PROBE_HISTOGRAMS 8
+#endif
+
+#ifndef LATENCY_PROBE_IN_FLIGHT
+  #define LATENCY_PROBE_IN_FLIGHT 8
+#endif
+
+struct latency_probe {
+  // Cycle clock at simulation time 0. Call right before run_until.
+  static void start(long long sim_us = 0) {
+    cycle_clock::init();
+    origin() = cycle_clock::now() - cycle_clock::from_us(sim_us);
+    started() = true;
+  }
+
+  // Cycle clock time of the simulation time sim_us, never later than now.
+  static cycle_clock::ticks scheduled(long long sim_us) {
+    const cycle_clock::ticks now = cycle_clock::now();
+    if(!started()) start(sim_us);
+    const cycle_clock::ticks ahead = cycle_clock::elapsed(now, origin() + cycle_clock::from_us(sim_us));
+    // A difference in the upper half of the range is a time in the past.
+    return ahead == 0 || ahead > (cycle_clock::ticks) -1 / 2 ? origin() + cycle_clock::from_us(sim_us) : now;
+  }
+
+  // A sample stamped at time is on its way to the controller.
+  static void sent(cycle_clock::ticks time) {
+    in_flight& f = flight();
+    if(f.count < LATENCY_PROBE_IN_FLIGHT) f.stamps[f.count++] = time;
+  }
+
+  // Oldest stamp of the samples sent since the last call, 0 if there were none.
+  static cycle_clock::ticks take_oldest() {
+    in_flight& f = flight();
+    const cycle_clock::ticks now = cycle_clock::now();
+    cycle_clock::ticks oldest = 0;
+    for(unsigned i = 0; i < f.count; i++) {
+      if(oldest == 0 || cycle_clock::elapsed(f.stamps[i], now) > cycle_clock::elapsed(oldest, now)) oldest = f.stamps[i];
+    }
+    f.count = 0;
+    return oldest;
+  }
+
+  // Input time of the event the outputs being sent now react to.
+  static cycle_clock::ticks& cause() {
+    static cycle_clock::ticks stamp = 0;
+    return stamp;
+  }
+
+  // Histogram registered under name, created on first use. nullptr when all slots are taken.
+  static LatencyHistogram* histogram(const char* name) {
+    return histograms().get(name);
+  }
+
+  static void report(FILE* out) {
+    histograms().for_each([&](const char* name, const LatencyHistogram& h) { h.print(out, name); });
+  }
+
+  template<typename BAGS>
+  static bool has_messages(const BAGS& bags) {
+    return has_messages(bags, std::make_index_sequence<std::tuple_size<BAGS>::value>());
+  }
+
+  private:
+    struct in_flight {
+      cycle_clock::ticks stamps[LATENCY_PROBE_IN_FLIGHT];
+      unsigned count = 0;
+    };
+
+    static NamedRegistry<LatencyHistogram, LATENCY_PROBE_HISTOGRAMS>& histograms() {
+      static NamedRegistry<LatencyHistogram, LATENCY_PROBE_HISTOGRAMS> table;
+      return table;
+    }
+
+    static in_flight& flight() {
+      static in_flight f;
+      return f;
+    }
+
+    static cycle_clock::ticks& origin() {
+      static cycle_clock::ticks t = 0;
+      return t;
+    }
+
+    static bool& started() {
+      static bool flag = false;
+      return flag;
+    }
+
+    template<typename BAGS, std::size_t... I>
+    static bool has_messages(const BAGS& bags, std::index_sequence<I...>) {
+      return (false || ... || !std::get<I>(bags).messages.empty());
+    }
+};
+
+// Models that know when their sample happened (an interrupt time) have sample_stamp().
+template<typename M, typename = void>
+struct has_sample_stamp : std::false_type {};
+
+template<typename M>
+struct has_sample_stamp<M, std::void_t<decltype(std::declval<const M&>().sample_stamp())>> : std::true_type {};
+
+template<template<typename> class MODEL>
+struct latency_source {
+    template<typename TIME>
+    class model : public decorator_base<MODEL<TIME>> {
+        using base=MODEL<TIME>;
+        public:
+            model() : decorator_base<base>(), now_us(0) {
+              cycle_clock::init();
+            }
+
+            template<typename... ARGs>
+            model(const instrumentation& config, ARGs&&... args) : decorator_base<base>(config, std::forward<ARGs>(args)...), now_us(0) {
+              cycle_clock::init();
+            }
+
+            void internal_transition() {
+              now_us += to_microseconds(base::time_advance());
+              base::internal_transition();
+            }
+
+            void external_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              now_us += to_microseconds(e);
+              base::external_transition(e, std::move(mbs));
+            }
+
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              now_us += to_microseconds(e);
+              base::confluence_transition(e, std::move(mbs));
+            }
+
+            typename cadmium::make_message_bags<typename base::output_ports>::type output() const {
+              auto bags = base::output();
+              #ifdef LATENCY_PROBES
+                if(latency_probe::has_messages(bags)) {
+                  latency_probe::sent(stamp());
+                }
+              #endif
+              return bags;
+            }
+
+        private:
+            cycle_clock::ticks stamp() const {
+              if constexpr(has_sample_stamp<base>::value) {
+                const cycle_clock::ticks edge = base::sample_stamp();
+                if(edge != 0) return edge;
+              }
+              #ifdef RT_ARM_MBED
+                return latency_probe::scheduled(now_us + to_microseconds(base::time_advance()));
+              #else
+                return cycle_clock::now();
+              #endif
+            }
+
+            long long now_us; // simulation time of the last transition
+    };
+};
+
+template<template<typename> class MODEL>
+struct latency_relay {
+    template<typename TIME>
+    class model : public decorator_base<MODEL<TIME>> {
+        using base=MODEL<TIME>;
+        public:
+            model() : decorator_base<base>(), stamp(0) {}
+
+            template<typename... ARGs>
+            model(const instrumentation& config, ARGs&&... args) : decorator_base<base>(config, std::forward<ARGs>(args)...), stamp(0) {}
+
+            // The outputs went out with the last output(): their cause is answered.
+            void internal_transition() {
+              stamp = 0;
+              base::internal_transition();
+            }
+
+            void external_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              receive();
+              base::external_transition(e, std::move(mbs));
+            }
+
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              stamp = 0;
+              receive();
+              base::confluence_transition(e, std::move(mbs));
+            }
+
+            typename cadmium::make_message_bags<typename base::output_ports>::type output() const {
+              #ifdef LATENCY_PROBES
+                latency_probe::cause() = stamp;
+              #endif
+              return base::output();
+            }
+
+        private:
+            // The oldest input not answered yet is the one the next outputs are late for.
+            void receive() {
+              #ifdef LATENCY_PROBES
+                const cycle_clock::ticks oldest = latency_probe::take_oldest();
+                if(oldest != 0 && (stamp == 0 || cycle_clock::elapsed(oldest, cycle_clock::now()) > cycle_clock::elapsed(stamp, cycle_clock::now()))) {
+                  stamp = oldest;
+                }
+              #endif
+            }
+
+            cycle_clock::ticks stamp;
+    };
+};
+
+template<template<typename> class MODEL>
+struct latency_sink {
+    template<typename TIME>
+    class model : public decorator_base<MODEL<TIME>> {
+        using base=MODEL<TIME>;
+        public:
+            model() : decorator_base<base>(), histogram(nullptr) {}
+
+            template<typename... ARGs>
+            model([[maybe_unused]] const instrumentation& config, ARGs&&... args) : decorator_base<base>(config, std::forward<ARGs>(args)...), histogram(nullptr) {
+              #ifdef LATENCY_PROBES
+                histogram = latency_probe::histogram(config.name);
+              #endif
+            }
+
+            void external_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              base::external_transition(e, std::move(mbs));
+              record();
+            }
+
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              base::confluence_transition(e, std::move(mbs));
+              record();
+            }
+
+        private:
+            void record() {
+              #ifdef LATENCY_PROBES
+                // Commands that answer no input (the initial ones) have no stamp.
+                if(histogram && latency_probe::cause() != 0) {
+                  histogram->record(cycle_clock::to_ns(cycle_clock::elapsed(latency_probe::cause(), cycle_clock::now())));
+                }
+              #endif
+            }
+
+            LatencyHistogram* histogram;
+    };
+};
+
+#endif // SEEED_BOT_LATENCY_PROBE_HPP
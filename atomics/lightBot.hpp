@@ -3,8 +3,12 @@
 *
 * Lightbot:
 * This model will drive towards a bright source of light using a Seed Bot Shield.
-
-
+*
+* It is the Controller (controller.hpp) with the light-differential policy: the bot turns
+* towards the brighter side when the left and right light sensors differ by more than
+* lightThreshold, and stops when the center IR sensor does not see the ground.
+* The light readings arrive either on the two single-sensor ports or together on lightPair
+* (DualAnalogInput), which keeps the left/right comparison within one ADC scan.
 */
 #ifndef BOOST_SIMULATION_PDEVS_LIGHTBOT_HPP
 #define BOOST_SIMULATION_PDEVS_LIGHTBOT_HPP
@@ -12,176 +16,92 @@
 //used libraries and headers
 #include <cadmium/modeling/ports.hpp>
 #include <cadmium/modeling/message_bag.hpp>
-#include <limits>
-#include <math.h> 
-#include <assert.h>
-#include <memory>
-#include <iomanip>
-#include <iostream>
-#include <fstream>
-#include <string>
-#include <chrono>
-#include <algorithm>
-#include <limits>
-#include <random>
-
-
-using namespace cadmium;
-using namespace std;
-
-
-
-enum DriveState {right = 0, straight = 1, left = 2, stop = 3};
-
+#include <tuple>
 
+#include "controller.hpp"
+#include "../data_structures/light_pair.hpp"
 
 //Port definition
-    struct lightBot_defs {
-        //Output ports
-        struct rightMotor1 : public out_port<float> { };
-        struct rightMotor2 : public out_port<bool> { };
-        struct leftMotor1 : public out_port<float> { };
-        struct leftMotor2 : public out_port<bool> { };
+    struct lightBot_defs : public controller_defs {
         //Input ports
-        struct rightLightSens : public in_port<float> { }; //analogic sensor => float
-        struct centerIR : public in_port<bool> { }; // digital sensor => bool
-        struct leftLightSens : public in_port<float> { };
+        struct rightLightSens : public cadmium::in_port<float> { }; //analogic sensor => float
+        struct centerIR : public cadmium::in_port<bool> { }; // digital sensor => bool
+        struct leftLightSens : public cadmium::in_port<float> { };
+        struct lightPair : public cadmium::in_port<light_pair> { }; // both light sensors from one ADC scan
     };
 
+#ifdef FIXED_MESSAGE_BAGS
+  FIXED_MESSAGE_BAG(lightBot_defs::rightLightSens, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(lightBot_defs::centerIR, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(lightBot_defs::leftLightSens, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(lightBot_defs::lightPair, FIXED_MESSAGE_BAG_CAPACITY)
+#endif
 
-    template<typename TIME>
-
-
-
-    class LightBot {
+    struct light_policy {
         using defs=lightBot_defs; // putting definitions in context
-        public:
-            //Parameters to be overwriten when instantiating the atomic model
-            TIME   slowToggleTime;
-            TIME   fastToggleTime;
-
-            // default constructor
-            LightBot() noexcept{
-              state.dir = straight;
-            }
-            
-            // state definition
-            struct state_type{
-              DriveState dir;
-              bool prop;
-              float lightRight;
-              float lightLeft;
-              bool centerIR;
-            }; 
-            state_type state;
-
-
-            // ports definition
-            using input_ports=std::tuple<typename defs::rightLightSens, typename defs::leftLightSens, typename defs::centerIR>;
-            using output_ports=std::tuple<typename defs::rightMotor1, typename defs::rightMotor2, typename defs::leftMotor1, typename defs::leftMotor2>;
+        using input_ports=std::tuple<defs::rightLightSens, defs::leftLightSens, defs::lightPair, defs::centerIR>;
+        static constexpr DriveState initial = DriveState::straight;
 
+        // Left/right light difference needed to turn.
+        float lightThreshold;
 
-            // internal transition
-            void internal_transition() {
-              state.prop = false;
-            }
+        light_policy() noexcept : lightThreshold(0.1) {}
+        light_policy(float threshold) noexcept : lightThreshold(threshold) {}
 
+        struct sensor_state {
+          float lightRight;
+          float lightLeft;
+          bool centerIR; // true when the center IR sensor does not see the ground
+        };
 
-            // external transition
-            void external_transition(TIME e, typename make_message_bags<input_ports>::type mbs) { 
-
-
-              for(const auto &x : get_messages<typename defs::centerIR>(mbs)){
-                state.centerIR = !x;
-              }
-              
-              for(const auto &x : get_messages<typename defs::rightLightSens>(mbs)){
-                state.lightRight = x;
-              }
-
-              for(const auto &x : get_messages<typename defs::leftLightSens>(mbs)){
-                state.lightLeft = x;
-              }              
-
-              if(state.centerIR) {
-                //if centerIR doesn't see the ground, bot stops
-                state.dir = DriveState::stop;
-              } else if ((state.lightLeft-state.lightRight) > 0.1) { //10% difference between left and right sensor
-                state.dir = DriveState::left;
-              } else if ((state.lightRight-state.lightLeft) > 0.1) {
-                state.dir = DriveState::right;
-              } else {
-                state.dir = DriveState::straight;
-              }
-              state.prop = true;
-            }
-
-            // confluence transition
-            void confluence_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
-              internal_transition();
-              external_transition(TIME(), std::move(mbs));
-            }
-
-            // output function
-            typename make_message_bags<output_ports>::type output() const {
-              typename make_message_bags<output_ports>::type bags;
-              float rightMotorOut1;
-              bool rightMotorOut2;
-              float leftMotorOut1;
-              bool leftMotorOut2;  
-
-              switch(state.dir){
-                case DriveState::right:
-                  rightMotorOut1 = 0;
-                  rightMotorOut2 = 0;
-                  leftMotorOut1 = 0;
-                  leftMotorOut2 = 1;                
-                break;
-
-                case DriveState::left:
-                  rightMotorOut1 = 0;
-                  rightMotorOut2 = 1;
-                  leftMotorOut1 = 0;
-                  leftMotorOut2 = 0;
-                break;
-
-                case DriveState::straight:
-                  rightMotorOut1 = 0;
-                  rightMotorOut2 = 1;
-                  leftMotorOut1 = 0;
-                  leftMotorOut2 = 1;
-                break;
-
-                case DriveState::stop:
-                default:
-                  rightMotorOut1 = 0;
-                  rightMotorOut2 = 0;
-                  leftMotorOut1 = 0;
-                  leftMotorOut2 = 0;
-                break;
-              }
-
-              get_messages<typename defs::rightMotor1>(bags).push_back(rightMotorOut1);
-              get_messages<typename defs::rightMotor2>(bags).push_back(rightMotorOut2);
-              get_messages<typename defs::leftMotor1>(bags).push_back(leftMotorOut1);
-              get_messages<typename defs::leftMotor2>(bags).push_back(leftMotorOut2);
-                
-              return bags;
-            }
+        template<typename BAGS>
+        void read(sensor_state& s, BAGS& mbs) const {
+          for(const auto &x : cadmium::get_messages<defs::centerIR>(mbs)){
+            s.centerIR = !x;
+          }
+          for(const auto &x : cadmium::get_messages<defs::rightLightSens>(mbs)){
+            s.lightRight = x;
+          }
+          for(const auto &x : cadmium::get_messages<defs::leftLightSens>(mbs)){
+            s.lightLeft = x;
+          }
+          for(const auto &x : cadmium::get_messages<defs::lightPair>(mbs)){
+            s.lightLeft = x.left;
+            s.lightRight = x.right;
+          }
+        }
+
+        DriveState decide(const sensor_state& s) const {
+          if(s.centerIR) {
+            //if centerIR doesn't see the ground, bot stops
+            return DriveState::stop;
+          } else if ((s.lightLeft-s.lightRight) > lightThreshold) { //10% difference between left and right sensor by default
+            return DriveState::left;
+          } else if ((s.lightRight-s.lightLeft) > lightThreshold) {
+            return DriveState::right;
+          }
+          return DriveState::straight;
+        }
+
+        motor_command command(DriveState dir, const sensor_state&) const {
+          return motors(dir);
+        }
+
+        // Motor table, indexed by DriveState (unknown drives like stop).
+        static constexpr motor_command table[] = {
+          /* right    */ {0, 0, 0, 1},
+          /* straight */ {0, 1, 0, 1},
+          /* left     */ {0, 1, 0, 0},
+          /* stop     */ {0, 0, 0, 0},
+          /* unknown  */ {0, 0, 0, 0}
+        };
 
-            // time_advance function
-            TIME time_advance() const { 
-            	if(state.prop){
-                	return TIME("00:00:00");
-                }else{
-              		return std::numeric_limits<TIME>::infinity();
-          		}
-            }
+        static constexpr motor_command motors(DriveState dir) {
+          return table[(int) dir];
+        }
+    };
 
-            friend std::ostringstream& operator<<(std::ostringstream& os, const typename LightBot<TIME>::state_type& i) {
-              os << "Current state: " << i.dir; 
-              return os;
-            }
-        };
+    template<typename TIME>
+    using LightBot = Controller<light_policy, TIME>;
 
-#endif // BOOST_SIMULATION_PDEVS_LIGHTBOT_HPP
\ No newline at end of file
+#endif // BOOST_SIMULATION_PDEVS_LIGHTBOT_HPP
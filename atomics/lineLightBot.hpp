@@ -0,0 +1,19 @@
+/**
+* ARSLab - Carleton University
+*
+* LineLightBot:
+* Line following and light seeking in one controller. Both policies read their own sensors;
+* the mode port selects which one drives the motors (false = light, true = line).
+* The decision code of both policies is compiled once and picked without virtual dispatch.
+*/
+#ifndef SEEED_BOT_LINE_LIGHT_BOT_HPP
+#define SEEED_BOT_LINE_LIGHT_BOT_HPP
+
+#include "controller.hpp"
+#include "lightBot.hpp"
+#include "seeedBotDriver.hpp"
+
+    template<typename TIME>
+    using LineLightBot = Controller<switchable_policy<light_policy, line_policy>, TIME>;
+
+#endif // SEEED_BOT_LINE_LIGHT_BOT_HPP
@@ -0,0 +1,235 @@
+/**
+* ARSLab - Carleton University
+*
+* Model Profiler:
+* Per-model event counts and CPU time. The profiled<M> decorator counts the internal, external
+* and confluence transitions and the output calls of the model it wraps, and adds up the
+* cycles spent in each (DWT cycle counter on target, steady_clock on desktop). Define
+* MODEL_PROFILER to turn it on; otherwise it is a plain pass-through. When on, each call
+* costs two cycle counter reads and three additions.
+*
+*   make_dynamic_atomic_model<profiled<LightBot>::model, TIME>("lightBot", instrumentation{"lightBot"});
+*   make_dynamic_atomic_model<ProfileReporter, TIME>("profiler", 10000000LL, &ring_sink_provider::sink());
+*
+* ProfileReporter prints every profile each period without blocking the control loop when
+* given the ring logger sink; model_profile::report() prints them once, e.g. after run_until.
+*/
+#ifndef SEEED_BOT_MODEL_PROFILER_HPP
+#define SEEED_BOT_MODEL_PROFILER_HPP
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <tuple>
+#include <utility>
+
+#include "../utilities/cycle_clock.hpp"
+#include "../utilities/instrumentation.hpp"
+#include "../utilities/named_registry.hpp"
+#include "../utilities/time_conversion.hpp"
+
+#ifndef MODEL_PROFILER_MODELS
+  #define MODEL_PROFILER_MODELS 12
+#endif
+
+struct model_profile {
+  enum call {INTERNAL = 0, EXTERNAL = 1, CONFLUENCE = 2, OUTPUT = 3, CALLS = 4};
+
+  unsigned long count[CALLS] = {};
+  uint64_t ticks[CALLS] = {};
+
+  void add(call c, cycle_clock::ticks start) {
+    count[c]++;
+    ticks[c] += cycle_clock::elapsed(start, cycle_clock::now());
+  }
+
+  // Profile registered under name, created on first use. nullptr when all slots are taken.
+  static model_profile* get(const char* name) {
+    return registry().get(name);
+  }
+
+  static void report(FILE* out) {
+    char line[224];
+    registry().for_each([&](const char* name, const model_profile& p) {
+      p.format(name, line, sizeof(line));
+      std::fputs(line, out);
+    });
+  }
+
+  static void report(std::ostream& out) {
+    char line[224];
+    registry().for_each([&](const char* name, const model_profile& p) {
+      p.format(name, line, sizeof(line));
+      out << line;
+    });
+    out.flush();
+  }
+
+  static void reset() {
+    registry().for_each([](const char*, model_profile& p) { p = model_profile(); });
+  }
+
+  private:
+    // "name  int count/us  ext count/us  conf count/us  out count/us  total us", one line.
+    void format(const char* name, char* line, std::size_t size) const {
+      uint64_t total = 0;
+      for(int c = 0; c < CALLS; c++) total += ticks[c];
+      std::snprintf(line, size, "%-14s int %8lu/%-9lu ext %8lu/%-9lu conf %8lu/%-9lu out %8lu/%-9lu total %lu us\n", name,
+                    count[INTERNAL], micros(ticks[INTERNAL]), count[EXTERNAL], micros(ticks[EXTERNAL]),
+                    count[CONFLUENCE], micros(ticks[CONFLUENCE]), count[OUTPUT], micros(ticks[OUTPUT]), micros(total));
+    }
+
+    static unsigned long micros(uint64_t t) {
+      return (unsigned long) (to_ns(t) / 1000);
+    }
+
+    // cycle_clock::to_ns works on one difference; the sums can exceed its range on target.
+    static uint64_t to_ns(uint64_t t) {
+      #ifdef RT_ARM_MBED
+        return t * 1000 / (SystemCoreClock / 1000000);
+      #else
+        return t;
+      #endif
+    }
+
+    static NamedRegistry<model_profile, MODEL_PROFILER_MODELS>& registry() {
+      static NamedRegistry<model_profile, MODEL_PROFILER_MODELS> profiles;
+      return profiles;
+    }
+};
+
+template<template<typename> class MODEL>
+struct profiled {
+    template<typename TIME>
+    class model : public decorator_base<MODEL<TIME>> {
+        using base=MODEL<TIME>;
+        public:
+            model() : decorator_base<base>(), profile(nullptr) {}
+
+            template<typename... ARGs>
+            model([[maybe_unused]] const instrumentation& config, ARGs&&... args) : decorator_base<base>(config, std::forward<ARGs>(args)...), profile(nullptr) {
+              #ifdef MODEL_PROFILER
+                cycle_clock::init();
+                profile = model_profile::get(config.name);
+              #endif
+            }
+
+            void internal_transition() {
+              const cycle_clock::ticks start = stamp();
+              base::internal_transition();
+              record(model_profile::INTERNAL, start);
+            }
+
+            void external_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              const cycle_clock::ticks start = stamp();
+              base::external_transition(e, std::move(mbs));
+              record(model_profile::EXTERNAL, start);
+            }
+
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              const cycle_clock::ticks start = stamp();
+              base::confluence_transition(e, std::move(mbs));
+              record(model_profile::CONFLUENCE, start);
+            }
+
+            typename cadmium::make_message_bags<typename base::output_ports>::type output() const {
+              const cycle_clock::ticks start = stamp();
+              auto bags = base::output();
+              record(model_profile::OUTPUT, start);
+              return bags;
+            }
+
+        private:
+            cycle_clock::ticks stamp() const {
+              #ifdef MODEL_PROFILER
+                if(profile) return cycle_clock::now();
+              #endif
+              return 0;
+            }
+
+            void record(model_profile::call c, cycle_clock::ticks start) const {
+              #ifdef MODEL_PROFILER
+                if(profile) profile->add(c, start);
+              #endif
+            }
+
+            model_profile* profile;
+    };
+};
+
+    // Prints model_profile::report() every period.
+    template<typename TIME>
+    class ProfileReporter {
+        public:
+            // default constructor
+            ProfileReporter() noexcept{
+              out = nullptr;
+              period_us = 10000000;
+              state.reports = 0;
+            }
+
+            ProfileReporter(long long period, std::ostream* sink) noexcept : ProfileReporter() {
+              period_us = period;
+              out = sink;
+            }
+
+            // state definition
+            struct state_type{
+              unsigned long reports;
+            };
+            state_type state;
+
+            // ports definition
+            using input_ports=std::tuple<>;
+            using output_ports=std::tuple<>;
+
+            // internal transition
+            void internal_transition() {
+              state.reports++;
+              if(out) {
+                *out << "profile " << format_time_string(state.reports * period_us) << "\n";
+                model_profile::report(*out);
+              } else {
+                std::printf("profile %s\n", format_time_string(state.reports * period_us).c_str());
+                model_profile::report(stdout);
+              }
+            }
+
+            // external transition
+            void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+            }
+
+            // confluence transition
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              internal_transition();
+            }
+
+            // output function
+            typename cadmium::make_message_bags<output_ports>::type output() const {
+              typename cadmium::make_message_bags<output_ports>::type bags;
+              return bags;
+            }
+
+            // time_advance function
+            TIME time_advance() const {
+              if(period_us <= 0) {
+                return std::numeric_limits<TIME>::infinity();
+              }
+              return from_microseconds<TIME>(period_us);
+            }
+
+            friend std::ostringstream& operator<<(std::ostringstream& os, const typename ProfileReporter<TIME>::state_type& i) {
+              os << "Reports: " << i.reports;
+              return os;
+            }
+
+        private:
+            long long period_us;
+            std::ostream* out;
+    };
+
+#endif // SEEED_BOT_MODEL_PROFILER_HPP
@@ -0,0 +1,148 @@
+/**
+* ARSLab - Carleton University
+*
+* Robot Plant:
+* One simulated Seeed Bot (utilities/robot_fleet.hpp) closing the loop around LightBot on
+* desktop: it takes the four motor ports and sends the center IR level and the light_pair
+* the robot senses, in place of the recorded input traces. The robot moves with the last
+* motor values received; every step_us it sends the light readings, and the center IR level
+* when it changed. Motor changes between two steps take effect at the time they arrive.
+* The robot lives in a robot_fleet owned by the caller, who reads its pose after the run.
+*
+* For many robots at once, step a robot_fleet directly (see closed_loop.cpp).
+*/
+#ifndef SEEED_BOT_ROBOT_PLANT_HPP
+#define SEEED_BOT_ROBOT_PLANT_HPP
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <limits>
+#include <sstream>
+
+#include "../data_structures/light_pair.hpp"
+#include "../utilities/robot_fleet.hpp"
+#include "../utilities/time_conversion.hpp"
+
+//Port definition
+    struct robotPlant_defs {
+        //Input ports
+        struct rightMotor1 : public cadmium::in_port<float> { };
+        struct rightMotor2 : public cadmium::in_port<bool> { };
+        struct leftMotor1 : public cadmium::in_port<float> { };
+        struct leftMotor2 : public cadmium::in_port<bool> { };
+        //Output ports
+        struct centerIR : public cadmium::out_port<bool> { };
+        struct lightPair : public cadmium::out_port<light_pair> { };
+    };
+
+    template<typename TIME>
+    class RobotPlant {
+        using defs=robotPlant_defs; // putting definitions in context
+        public:
+            // default constructor
+            RobotPlant() noexcept : RobotPlant(nullptr) {}
+
+            // Simulates robot 0 of a fleet owned by the caller (a fleet of one, as the other
+            // robots would be stepped along with it).
+            RobotPlant(robot_fleet* fleet, long long step = 10000) noexcept : robot(fleet), step_us(step) {
+              state.motors = {0, false, 0, false};
+              state.remaining_us = 0;
+              state.send = robot != nullptr;
+              state.ground = true;
+              state.lights = {0, 0};
+              if(robot) {
+                robot->sense();
+                state.ground = robot->ground[0] != 0;
+                state.lights = {robot->left_light[0], robot->right_light[0]};
+              }
+              state.sentGround = !state.ground;
+            }
+
+            // state definition
+            struct state_type{
+              struct { float rightMotor1; bool rightMotor2; float leftMotor1; bool leftMotor2; } motors;
+              long long remaining_us; // until the next step
+              bool send;              // sensor values are due now
+              bool ground;            // center IR level
+              bool sentGround;        // last center IR level sent
+              light_pair lights;
+            };
+            state_type state;
+
+            // ports definition
+            using input_ports=std::tuple<typename defs::rightMotor1, typename defs::rightMotor2, typename defs::leftMotor1, typename defs::leftMotor2>;
+            using output_ports=std::tuple<typename defs::centerIR, typename defs::lightPair>;
+
+            // internal transition
+            void internal_transition() {
+              if(state.send) {
+                state.send = false;
+                state.sentGround = state.ground;
+                state.remaining_us = step_us;
+                return;
+              }
+              advance(state.remaining_us);
+              state.send = true;
+            }
+
+            // external transition
+            void external_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              if(!state.send) {
+                const long long elapsed = to_microseconds(e);
+                advance(elapsed);
+                state.remaining_us -= elapsed;
+              }
+              for(const auto &x : cadmium::get_messages<typename defs::rightMotor1>(mbs)) state.motors.rightMotor1 = x;
+              for(const auto &x : cadmium::get_messages<typename defs::rightMotor2>(mbs)) state.motors.rightMotor2 = x;
+              for(const auto &x : cadmium::get_messages<typename defs::leftMotor1>(mbs)) state.motors.leftMotor1 = x;
+              for(const auto &x : cadmium::get_messages<typename defs::leftMotor2>(mbs)) state.motors.leftMotor2 = x;
+              if(robot) robot->set_motors(0, state.motors.rightMotor1, state.motors.rightMotor2, state.motors.leftMotor1, state.motors.leftMotor2);
+            }
+
+            // confluence transition
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<input_ports>::type mbs) {
+              internal_transition();
+              external_transition(TIME(), std::move(mbs));
+            }
+
+            // output function
+            typename cadmium::make_message_bags<output_ports>::type output() const {
+              typename cadmium::make_message_bags<output_ports>::type bags;
+              if(state.send) {
+                if(state.ground != state.sentGround) {
+                  cadmium::get_messages<typename defs::centerIR>(bags).push_back(state.ground);
+                }
+                cadmium::get_messages<typename defs::lightPair>(bags).push_back(state.lights);
+              }
+              return bags;
+            }
+
+            // time_advance function
+            TIME time_advance() const {
+              if(state.send) {
+                return TIME();
+              }
+              if(!robot) {
+                return std::numeric_limits<TIME>::infinity();
+              }
+              return from_microseconds<TIME>(state.remaining_us);
+            }
+
+            friend std::ostringstream& operator<<(std::ostringstream& os, const typename RobotPlant<TIME>::state_type& i) {
+              os << "Ground: " << i.ground << " Light: " << i.lights;
+              return os;
+            }
+
+        private:
+            void advance(long long us) {
+              if(us <= 0 || !robot) return;
+              robot->step(us * 1e-6f);
+              state.ground = robot->ground[0] != 0;
+              state.lights = {robot->left_light[0], robot->right_light[0]};
+            }
+
+            robot_fleet* robot;
+            long long step_us;
+    };
+
+#endif // SEEED_BOT_ROBOT_PLANT_HPP
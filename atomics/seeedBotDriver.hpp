@@ -6,6 +6,8 @@
 * This model will do simple line following using a Seed Bot Shield.
 * Its purpose is to demonstrate how to use all of the port IO models in RT_ARM_MBED.
 *
+* It is the Controller (controller.hpp) with the 3-IR line following policy.
+*
 * Note: The 'SCARED_OF_THE_DARK' macro will read from a Grove light sensor on 
 *   analog port A5 and stop the car if the reading is less then 0.3.
 * It must be defined here and in main if being used.
@@ -15,181 +17,136 @@
 
 #include <cadmium/modeling/ports.hpp>
 #include <cadmium/modeling/message_bag.hpp>
-#include <limits>
-#include <math.h> 
-#include <assert.h>
-#include <memory>
-#include <iomanip>
-#include <iostream>
-#include <fstream>
-#include <string>
-#include <chrono>
-#include <algorithm>
-#include <limits>
-#include <random>
+#include <tuple>
+
+#include "controller.hpp"
 
  //#define SCARED_OF_THE_DARK
 
-using namespace cadmium;
-using namespace std;
-enum DriveState {right = 0, straight = 1, left = 2, stop = 3, unknown = 4};
 //Port definition
-    struct seeedBotDriver_defs {
-        //Output ports
-        struct rightMotor1 : public out_port<float> { };
-        struct rightMotor2 : public out_port<bool> { };
-        struct leftMotor1 : public out_port<float> { };
-        struct leftMotor2 : public out_port<bool> { };
+    struct seeedBotDriver_defs : public controller_defs {
         //Input ports
-        struct rightIR : public in_port<bool> { };
-        struct centerIR : public in_port<bool> { };
-        struct leftIR : public in_port<bool> { };
+        struct rightIR : public cadmium::in_port<bool> { };
+        struct centerIR : public cadmium::in_port<bool> { };
+        struct leftIR : public cadmium::in_port<bool> { };
         #ifdef SCARED_OF_THE_DARK
-        struct lightSensor : public in_port<float> { };
+        struct lightSensor : public cadmium::in_port<float> { };
         #endif
     };
 
-    template<typename TIME>
-    class SeeedBotDriver {
+#ifdef FIXED_MESSAGE_BAGS
+  FIXED_MESSAGE_BAG(seeedBotDriver_defs::rightIR, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(seeedBotDriver_defs::centerIR, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(seeedBotDriver_defs::leftIR, FIXED_MESSAGE_BAG_CAPACITY)
+  #ifdef SCARED_OF_THE_DARK
+  FIXED_MESSAGE_BAG(seeedBotDriver_defs::lightSensor, FIXED_MESSAGE_BAG_CAPACITY)
+  #endif
+#endif
+
+    struct line_policy {
         using defs=seeedBotDriver_defs; // putting definitions in context
-        public:
-            //Parameters to be overwriten when instantiating the atomic model
-            TIME   slowToggleTime;
-            TIME   fastToggleTime;
-            // default constructor
-            SeeedBotDriver() noexcept{
-              state.dir = unknown;
-            }
-            
-            // state definition
-            struct state_type{
-              bool leftIR;
-              bool centerIR;
-              bool rightIR;
-              DriveState dir;
-              bool prop;
-            }; 
-            state_type state;
-            // ports definition
-            #ifdef SCARED_OF_THE_DARK
-            using input_ports=std::tuple<typename defs::rightIR, typename defs::lightSensor, typename defs::centerIR, typename defs::leftIR>;
-            #else
-            using input_ports=std::tuple<typename defs::rightIR, typename defs::centerIR, typename defs::leftIR>;
-            #endif
-            using output_ports=std::tuple<typename defs::rightMotor1, typename defs::rightMotor2, typename defs::leftMotor1, typename defs::leftMotor2>;
-
-            // internal transition
-            void internal_transition() {
-              state.prop = false;
-              //Do nothing... 
-            }
-
-            // external transition
-            void external_transition(TIME e, typename make_message_bags<input_ports>::type mbs) { 
-              float light = 0;
-              DriveState oldState = state.dir;
-              // Note: This will search the message bags for each port and store only the LAST value in the state variable.
-              // Saving the inputs in a state variable is required since not all sensors are update at the same time.
-              // For example, if a new rightIR reading comes through we need to know the last center and left IR readings 
-              // to make the drive direction decision.
-              for(const auto &x : get_messages<typename defs::rightIR>(mbs)){
-                state.rightIR = !x;
-              }
-              for(const auto &x : get_messages<typename defs::centerIR>(mbs)){
-                state.centerIR = !x;
-              }
-              for(const auto &x : get_messages<typename defs::leftIR>(mbs)){
-                state.leftIR = !x;
-              }
-              #ifdef SCARED_OF_THE_DARK
-              for(const auto &x : get_messages<typename defs::lightSensor>(mbs)){
-                light = x;
-              }
-              #endif
-              if((!(state.rightIR ^ state.leftIR ^ state.centerIR) && !(!state.rightIR && !state.leftIR && !state.centerIR)) || (state.rightIR && state.leftIR && state.centerIR)) {
-                // This happens when no IR sensors see the line and if two or more IR sensors see the line.
-                state.dir = DriveState::stop;
-              } else if (state.rightIR) {
-                state.dir = DriveState::left;
-              } else if (state.leftIR) {
-                state.dir = DriveState::right;
-              } else {
-                state.dir = DriveState::straight;
-              }
-              #ifdef SCARED_OF_THE_DARK
-              if (light < 0.3) {
-                state.dir = DriveState::stop;
-              }
-              #endif
-              // If the state changes, force an output.
-              state.prop = true; //state.dir == oldState;
-            }
-
-            // confluence transition
-            void confluence_transition(TIME e, typename make_message_bags<input_ports>::type mbs) {
-              internal_transition();
-              external_transition(TIME(), std::move(mbs));
-            }
-
-            // output function
-            typename make_message_bags<output_ports>::type output() const {
-              typename make_message_bags<output_ports>::type bags;
-              float rightMotorOut1;
-              bool rightMotorOut2;
-              float leftMotorOut1;
-              bool leftMotorOut2;  
-
-              switch(state.dir){
-                case DriveState::right:
-                  rightMotorOut1 = 0.5;
-                  rightMotorOut2 = 0;
-                  leftMotorOut1 = 1;
-                  leftMotorOut2 = 1;                
-                break;
-
-                case DriveState::left:
-                  rightMotorOut1 = 1;
-                  rightMotorOut2 = 1;
-                  leftMotorOut1 = 0.5;
-                  leftMotorOut2 = 0;
-                break;
-
-                case DriveState::straight:
-                  rightMotorOut1 = 0.5;
-                  rightMotorOut2 = 0;
-                  leftMotorOut1 = 0.5;
-                  leftMotorOut2 = 0;
-                break;
-
-                case DriveState::stop:
-                default:
-                  rightMotorOut1 = 0;
-                  rightMotorOut2 = 0;
-                  leftMotorOut1 = 0;
-                  leftMotorOut2 = 0;
-                break;
-              }
-
-              get_messages<typename defs::rightMotor1>(bags).push_back(rightMotorOut1);
-              get_messages<typename defs::rightMotor2>(bags).push_back(rightMotorOut2);
-              get_messages<typename defs::leftMotor1>(bags).push_back(leftMotorOut1);
-              get_messages<typename defs::leftMotor2>(bags).push_back(leftMotorOut2);
-                
-              return bags;
-            }
-
-            // time_advance function
-            TIME time_advance() const { 
-              if(state.prop)
-                return TIME("00:00:00");
-              return std::numeric_limits<TIME>::infinity();
-            }
-
-            friend std::ostringstream& operator<<(std::ostringstream& os, const typename SeeedBotDriver<TIME>::state_type& i) {
-              os << "Current state: " << i.dir; 
-              return os;
-            }
-        };     
-
-
-#endif // BOOST_SIMULATION_PDEVS_BLINKY_HPP
\ No newline at end of file
+        #ifdef SCARED_OF_THE_DARK
+        using input_ports=std::tuple<defs::rightIR, defs::lightSensor, defs::centerIR, defs::leftIR>;
+        #else
+        using input_ports=std::tuple<defs::rightIR, defs::centerIR, defs::leftIR>;
+        #endif
+        static constexpr DriveState initial = DriveState::unknown;
+
+        // Sensor bits, set when the sensor sees the line (DARK: light reading below 0.3).
+        enum sensor_bit : unsigned char {LEFT_IR = 1, CENTER_IR = 2, RIGHT_IR = 4, DARK = 8};
+
+        struct sensor_state {
+          #ifdef SCARED_OF_THE_DARK
+          unsigned char bits = DARK; // no light reading yet
+          #else
+          unsigned char bits = 0;
+          #endif
+        };
+
+        // Note: This will search the message bags for each port and store only the LAST value in the state variable.
+        // Saving the inputs in a state variable is required since not all sensors are update at the same time.
+        // For example, if a new rightIR reading comes through we need to know the last center and left IR readings 
+        // to make the drive direction decision.
+        template<typename BAGS>
+        void read(sensor_state& s, BAGS& mbs) const {
+          for(const auto &x : cadmium::get_messages<defs::rightIR>(mbs)){
+            s.bits = (s.bits & ~RIGHT_IR) | (!x << 2);
+          }
+          for(const auto &x : cadmium::get_messages<defs::centerIR>(mbs)){
+            s.bits = (s.bits & ~CENTER_IR) | (!x << 1);
+          }
+          for(const auto &x : cadmium::get_messages<defs::leftIR>(mbs)){
+            s.bits = (s.bits & ~LEFT_IR) | !x;
+          }
+          #ifdef SCARED_OF_THE_DARK
+          for(const auto &x : cadmium::get_messages<defs::lightSensor>(mbs)){
+            s.bits = (s.bits & ~DARK) | ((x < 0.3f) << 3);
+          }
+          #endif
+        }
+
+        // Drive direction for every combination of sensor bits.
+        static constexpr DriveState decisions[16] = {
+          /* none         */ DriveState::straight,
+          /* L            */ DriveState::right,
+          /* C            */ DriveState::straight,
+          /* L C          */ DriveState::stop,
+          /* R            */ DriveState::left,
+          /* R L          */ DriveState::stop,
+          /* R C          */ DriveState::stop,
+          /* R C L        */ DriveState::stop,
+          /* dark, any IR */ DriveState::stop, DriveState::stop, DriveState::stop, DriveState::stop,
+                             DriveState::stop, DriveState::stop, DriveState::stop, DriveState::stop
+        };
+
+        DriveState decide(const sensor_state& s) const {
+          return decisions[s.bits & 15];
+        }
+
+        // The branching form of the decision, kept as the specification of the table.
+        static constexpr DriveState reference_decision(unsigned char bits) {
+          const bool rightIR = bits & RIGHT_IR, centerIR = bits & CENTER_IR, leftIR = bits & LEFT_IR;
+          DriveState dir = DriveState::straight;
+          if((!(rightIR ^ leftIR ^ centerIR) && !(!rightIR && !leftIR && !centerIR)) || (rightIR && leftIR && centerIR)) {
+            // This happens when two or more IR sensors see the line.
+            dir = DriveState::stop;
+          } else if (rightIR) {
+            dir = DriveState::left;
+          } else if (leftIR) {
+            dir = DriveState::right;
+          }
+          if (bits & DARK) {
+            dir = DriveState::stop;
+          }
+          return dir;
+        }
+
+        static constexpr bool decisions_match_reference(unsigned char bits = 0) {
+          return bits == 16 || (decisions[bits] == reference_decision(bits) && decisions_match_reference(bits + 1));
+        }
+
+        motor_command command(DriveState dir, const sensor_state&) const {
+          return motors(dir);
+        }
+
+        // Motor table, indexed by DriveState (unknown drives like stop).
+        static constexpr motor_command table[] = {
+          /* right    */ {0.5, 0, 1, 1},
+          /* straight */ {0.5, 0, 0.5, 0},
+          /* left     */ {1, 1, 0.5, 0},
+          /* stop     */ {0, 0, 0, 0},
+          /* unknown  */ {0, 0, 0, 0}
+        };
+
+        static constexpr motor_command motors(DriveState dir) {
+          return table[(int) dir];
+        }
+    };
+
+    // Checked for all 16 sensor combinations at compile time.
+    static_assert(line_policy::decisions_match_reference(), "line_policy::decisions differs from the reference decision");
+
+    template<typename TIME>
+    using SeeedBotDriver = Controller<line_policy, TIME>;
+
+#endif // BOOST_SIMULATION_PDEVS_BLINKY_HPP
@@ -0,0 +1,159 @@
+/**
+* ARSLab - Carleton University
+*
+* SteeringBot:
+* LightBot with proportional (or PI) steering instead of the three-way left/straight/right
+* decision. Both direction pins stay high and the wheel on the brighter side is slowed down
+* with its PWM pin, by an amount proportional to the left-right light difference, so the bot
+* curves towards the light instead of switching between turning and driving straight.
+*
+* It uses the LightBot ports (lightBot_defs), so it drops in wherever LightBot is coupled:
+*
+*   make_dynamic_atomic_model<SteeringBot, TIME>("lightBot", true, steering_gains{8.0f, 0.0f, 0.03f, 2});
+*
+* The loop runs in fixed point: each light reading is converted once to Q15, the gains are
+* Q8.8 and the duty is quantized to a few levels taken from a table, so a sample costs integer
+* operations only. The duty level is computed once per light sample, when it is read, and
+* decide() and command() both use it. The quantization and the deadband also keep the motor ports quiet: with
+* change detection a PWM port is only sent when the duty moves to another level.
+*/
+#ifndef SEEED_BOT_STEERING_BOT_HPP
+#define SEEED_BOT_STEERING_BOT_HPP
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/message_bag.hpp>
+#include <cstdint>
+#include <tuple>
+
+#include "controller.hpp"
+#include "lightBot.hpp"
+
+struct steering_gains {
+  float kp;          // duty per unit of light difference (1 = full turn at difference 1)
+  float ki;          // duty added per sample per unit of light difference
+  float deadband;    // light differences below this give no proportional term
+  unsigned levels;   // duty levels between 0 and full turn (1 to 32)
+};
+
+// Tuned with CLOSED_LOOP -c steer: three duty levels (0, 0.5, 1) are enough to curve smoothly.
+// More robots reach the light than with LightBot, but they do not get there sooner (README).
+constexpr steering_gains default_steering = {8.0f, 0.0f, 0.03f, 2};
+
+    struct steering_policy {
+        using defs=lightBot_defs; // putting definitions in context
+        using input_ports=std::tuple<defs::rightLightSens, defs::leftLightSens, defs::lightPair, defs::centerIR>;
+        static constexpr DriveState initial = DriveState::straight;
+
+        static constexpr int32_t ONE = 32767; // 1.0 in Q15
+
+        int32_t kp;       // Q8.8
+        int32_t ki;       // Q8.8
+        int32_t deadband; // Q15
+        int32_t levels;
+        float duty[33];   // PWM value of each level
+
+        steering_policy() noexcept : steering_policy(default_steering) {}
+
+        steering_policy(const steering_gains& gains) noexcept {
+          // Up to 64, so kp * error fits in 32 bits.
+          kp = (int32_t) ((gains.kp < 0 ? 0 : (gains.kp > 64 ? 64 : gains.kp)) * 256.0f + 0.5f);
+          ki = (int32_t) ((gains.ki < 0 ? 0 : (gains.ki > 64 ? 64 : gains.ki)) * 256.0f + 0.5f);
+          deadband = q15(gains.deadband);
+          levels = gains.levels < 1 ? 1 : (gains.levels > 32 ? 32 : (int32_t) gains.levels);
+          for(int32_t k = 0; k <= levels; k++) duty[k] = (float) k / levels;
+        }
+
+        struct sensor_state {
+          int32_t lightRight; // Q15
+          int32_t lightLeft;  // Q15
+          int32_t integral;   // Q15, clamped to +-1 (anti-windup)
+          int32_t level;      // signed duty level of the last light sample, see steer()
+          bool centerIR;      // true when the center IR sensor does not see the ground
+        };
+
+        template<typename BAGS>
+        void read(sensor_state& s, BAGS& mbs) const {
+          bool fresh = false;
+          for(const auto &x : cadmium::get_messages<defs::centerIR>(mbs)){
+            s.centerIR = !x;
+          }
+          for(const auto &x : cadmium::get_messages<defs::rightLightSens>(mbs)){
+            s.lightRight = q15(x);
+            fresh = true;
+          }
+          for(const auto &x : cadmium::get_messages<defs::leftLightSens>(mbs)){
+            s.lightLeft = q15(x);
+            fresh = true;
+          }
+          for(const auto &x : cadmium::get_messages<defs::lightPair>(mbs)){
+            s.lightLeft = q15(x.left);
+            s.lightRight = q15(x.right);
+            fresh = true;
+          }
+          // The integral and the level move once per light sample, whichever ports it came on.
+          if(fresh) update(s);
+        }
+
+        // Sets both light readings at once, as read() does for a lightPair.
+        void light(sensor_state& s, float left, float right) const {
+          s.lightLeft = q15(left);
+          s.lightRight = q15(right);
+          update(s);
+        }
+
+        DriveState decide(const sensor_state& s) const {
+          if(s.centerIR) {
+            //if centerIR doesn't see the ground, bot stops
+            return DriveState::stop;
+          }
+          if(s.level > 0) return DriveState::left;
+          if(s.level < 0) return DriveState::right;
+          return DriveState::straight;
+        }
+
+        // Positive levels slow the left wheel (turn left), negative ones the right wheel.
+        motor_command command(DriveState dir, const sensor_state& s) const {
+          if(dir == DriveState::stop || dir == DriveState::unknown) {
+            return light_policy::motors(DriveState::stop);
+          }
+          return {s.level < 0 ? duty[-s.level] : 0.0f, true, s.level > 0 ? duty[s.level] : 0.0f, true};
+        }
+
+        // Three-way motor table for motorCommand(), the same as LightBot's.
+        static constexpr motor_command motors(DriveState dir) {
+          return light_policy::motors(dir);
+        }
+
+        static int32_t q15(float value) {
+          if(!(value > 0)) return 0;
+          if(value >= 1) return ONE;
+          return (int32_t) (value * ONE + 0.5f);
+        }
+
+    private:
+        void update(sensor_state& s) const {
+          if(ki != 0) {
+            const int32_t error = s.lightLeft - s.lightRight;
+            s.integral = clamp(s.integral + ((ki * error) >> 8));
+          }
+          s.level = steer(s);
+        }
+
+        // Signed duty level, -levels to levels.
+        int32_t steer(const sensor_state& s) const {
+          const int32_t error = s.lightLeft - s.lightRight;
+          const int32_t proportional = (error < deadband && error > -deadband) ? 0 : (kp * error) >> 8;
+          const int32_t u = clamp(proportional + s.integral);
+          const int32_t magnitude = ((u < 0 ? -u : u) * levels + (1 << 14)) >> 15;
+          return u < 0 ? -magnitude : magnitude;
+        }
+
+        static int32_t clamp(int32_t v) {
+          return v > ONE ? ONE : (v < -ONE ? -ONE : v);
+        }
+    };
+
+    template<typename TIME>
+    using SteeringBot = Controller<steering_policy, TIME>;
+
+#endif // SEEED_BOT_STEERING_BOT_HPP
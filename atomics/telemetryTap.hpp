@@ -0,0 +1,131 @@
+/**
+* ARSLab - Carleton University
+*
+* Telemetry Tap:
+* Decorators that write the pin changes of a model to the telemetry stream
+* (utilities/telemetry.hpp), stamped with the simulation time, without changing any port.
+* Define TELEMETRY to turn them on; otherwise they are plain pass-throughs.
+*
+*   telemetry_source<M>  input models: every value sent is a change of the pin.
+*   telemetry_sink<M>    output models: every value received is a change of the pin.
+*
+*   make_dynamic_atomic_model<telemetry_source<DigitalInput>::model, TIME>("centerIR", instrumentation{"centerIR", {}, no_input_filter, telemetry_pin::A2}, A2);
+*   make_dynamic_atomic_model<telemetry_sink<PwmOutput>::model, TIME>("rightMotor1", instrumentation{"rightMotor1", {}, no_input_filter, telemetry_pin::D11}, D11);
+*
+* A light_pair is written as two records, left on the given pin (A4) and right on the next one (A5).
+*/
+#ifndef SEEED_BOT_TELEMETRY_TAP_HPP
+#define SEEED_BOT_TELEMETRY_TAP_HPP
+
+#include <cadmium/modeling/message_bag.hpp>
+#include <tuple>
+#include <utility>
+
+#include "../data_structures/light_pair.hpp"
+#include "../utilities/instrumentation.hpp"
+#include "../utilities/telemetry.hpp"
+#include "../utilities/time_conversion.hpp"
+
+namespace telemetry {
+  inline void write(telemetry_pin pin, long long time_us, bool level) {
+    telemetry_stream().record(pin, time_us, level);
+  }
+
+  inline void write(telemetry_pin pin, long long time_us, float value) {
+    telemetry_stream().record(pin, time_us, value);
+  }
+
+  inline void write(telemetry_pin pin, long long time_us, const light_pair& lights) {
+    telemetry_stream().record(pin, time_us, lights.left);
+    telemetry_stream().record((telemetry_pin) ((uint8_t) pin + 1), time_us, lights.right);
+  }
+
+  // Writes the last message of every bag; earlier ones at the same instant are overwritten on the pin.
+  template<typename BAGS>
+  void write_bags(telemetry_pin pin, long long time_us, const BAGS& bags) {
+    std::apply([&](const auto&... bag) {
+      ((bag.messages.empty() ? void() : write(pin, time_us, bag.messages.back())), ...);
+    }, bags);
+  }
+}
+
+template<template<typename> class MODEL>
+struct telemetry_source {
+    template<typename TIME>
+    class model : public decorator_base<MODEL<TIME>> {
+        using base=MODEL<TIME>;
+        public:
+            model() : decorator_base<base>(), pin(telemetry_pin::A2), now_us(0) {}
+
+            template<typename... ARGs>
+            model(const instrumentation& config, ARGs&&... args) : decorator_base<base>(config, std::forward<ARGs>(args)...), pin(config.pin), now_us(0) {}
+
+            void internal_transition() {
+              now_us += to_microseconds(base::time_advance());
+              base::internal_transition();
+            }
+
+            void external_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              now_us += to_microseconds(e);
+              base::external_transition(e, std::move(mbs));
+            }
+
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              now_us += to_microseconds(e);
+              base::confluence_transition(e, std::move(mbs));
+            }
+
+            typename cadmium::make_message_bags<typename base::output_ports>::type output() const {
+              auto bags = base::output();
+              #ifdef TELEMETRY
+                // Outputs are sent at the end of the current time advance.
+                telemetry::write_bags(pin, now_us + to_microseconds(base::time_advance()), bags);
+              #endif
+              return bags;
+            }
+
+        private:
+            telemetry_pin pin;
+            long long now_us; // time of the last transition
+    };
+};
+
+template<template<typename> class MODEL>
+struct telemetry_sink {
+    template<typename TIME>
+    class model : public decorator_base<MODEL<TIME>> {
+        using base=MODEL<TIME>;
+        public:
+            model() : decorator_base<base>(), pin(telemetry_pin::D8), now_us(0) {}
+
+            template<typename... ARGs>
+            model(const instrumentation& config, ARGs&&... args) : decorator_base<base>(config, std::forward<ARGs>(args)...), pin(config.pin), now_us(0) {}
+
+            void internal_transition() {
+              now_us += to_microseconds(base::time_advance());
+              base::internal_transition();
+            }
+
+            void external_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              now_us += to_microseconds(e);
+              #ifdef TELEMETRY
+                telemetry::write_bags(pin, now_us, mbs);
+              #endif
+              base::external_transition(e, std::move(mbs));
+            }
+
+            void confluence_transition(TIME e, typename cadmium::make_message_bags<typename base::input_ports>::type mbs) {
+              now_us += to_microseconds(e);
+              #ifdef TELEMETRY
+                telemetry::write_bags(pin, now_us, mbs);
+              #endif
+              base::confluence_transition(e, std::move(mbs));
+            }
+
+        private:
+            telemetry_pin pin;
+            long long now_us; // time of the last transition
+    };
+};
+
+#endif // SEEED_BOT_TELEMETRY_TAP_HPP
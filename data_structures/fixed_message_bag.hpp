@@ -0,0 +1,35 @@
+/**
+* ARSLab - Carleton University
+*
+* Fixed Message Bag:
+* Specializes cadmium::message_bag for a port so that its messages are kept in a
+* static_vector instead of a std::vector. Models using those ports build, fill and
+* pass their bags without any heap allocation.
+*
+* The specialization must come right after the port definition, before any model using
+* the port is instantiated:
+*   FIXED_MESSAGE_BAG(lightBot_defs::rightMotor1, FIXED_MESSAGE_BAG_CAPACITY)
+*/
+#ifndef SEEED_BOT_FIXED_MESSAGE_BAG_HPP
+#define SEEED_BOT_FIXED_MESSAGE_BAG_HPP
+
+#include <cadmium/modeling/message_bag.hpp>
+
+#include "static_vector.hpp"
+
+// Messages a bag can hold. The models send at most one message per port and event.
+#ifndef FIXED_MESSAGE_BAG_CAPACITY
+  #define FIXED_MESSAGE_BAG_CAPACITY 4
+#endif
+
+#define FIXED_MESSAGE_BAG(PORT, CAPACITY)                                        \
+  namespace cadmium {                                                            \
+    template<>                                                                   \
+    struct message_bag<PORT> {                                                   \
+      using port = PORT;                                                         \
+      using message_type = typename PORT::message_type;                          \
+      static_vector<message_type, CAPACITY> messages;                            \
+    };                                                                           \
+  }
+
+#endif // SEEED_BOT_FIXED_MESSAGE_BAG_HPP
@@ -0,0 +1,43 @@
+/**
+* ARSLab - Carleton University
+*
+* Light Pair:
+* Left and right light sensor readings taken in the same ADC scan, sent as one message
+* by DualAnalogInput to the lightPair port of LightBot.
+*/
+#ifndef SEEED_BOT_LIGHT_PAIR_HPP
+#define SEEED_BOT_LIGHT_PAIR_HPP
+
+#include <cmath>
+#include <istream>
+#include <ostream>
+
+struct light_pair {
+  float left;
+  float right;
+};
+
+inline bool operator==(const light_pair& a, const light_pair& b) {
+  return a.left == b.left && a.right == b.right;
+}
+
+inline bool operator!=(const light_pair& a, const light_pair& b) {
+  return !(a == b);
+}
+
+// Change between two pairs, as seen by the input filters: the larger of the two channels.
+inline float filter_distance(const light_pair& a, const light_pair& b) {
+  const float left = std::fabs(a.left - b.left);
+  const float right = std::fabs(a.right - b.right);
+  return left > right ? left : right;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const light_pair& p) {
+  return os << p.left << " " << p.right;
+}
+
+inline std::istream& operator>>(std::istream& is, light_pair& p) {
+  return is >> p.left >> p.right;
+}
+
+#endif // SEEED_BOT_LIGHT_PAIR_HPP
@@ -0,0 +1,88 @@
+/**
+* ARSLab - Carleton University
+*
+* Static Vector:
+* Fixed-capacity vector with inline storage. It provides the part of the std::vector
+* interface the Cadmium engines and the atomic models use on message bags,
+* without ever touching the heap. Going over the capacity is a programming error (assert).
+*/
+#ifndef SEEED_BOT_STATIC_VECTOR_HPP
+#define SEEED_BOT_STATIC_VECTOR_HPP
+
+#include <assert.h>
+#include <cstddef>
+#include <initializer_list>
+
+template<typename T, std::size_t CAPACITY>
+class static_vector {
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using reference = T&;
+        using const_reference = const T&;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        static_vector() noexcept : count(0) {}
+
+        static_vector(std::initializer_list<T> list) : count(0) {
+          for(const T& item : list) push_back(item);
+        }
+
+        void push_back(const T& item) {
+          assert(count < CAPACITY);
+          items[count++] = item;
+        }
+
+        template<typename... ARGs>
+        void emplace_back(ARGs&&... args) {
+          push_back(T(args...));
+        }
+
+        // Only appending at the end is supported.
+        template<typename ITERATOR>
+        iterator insert(const_iterator position, ITERATOR first, ITERATOR last) {
+          assert(position == end());
+          iterator inserted = end();
+          for(; first != last; ++first) push_back(*first);
+          return inserted;
+        }
+
+        void pop_back() { assert(count > 0); count--; }
+        void clear() noexcept { count = 0; }
+        void reserve(size_type n) const { assert(n <= CAPACITY); }
+
+        size_type size() const noexcept { return count; }
+        bool empty() const noexcept { return count == 0; }
+        static constexpr size_type capacity() noexcept { return CAPACITY; }
+        static constexpr size_type max_size() noexcept { return CAPACITY; }
+
+        reference operator[](size_type i) { return items[i]; }
+        const_reference operator[](size_type i) const { return items[i]; }
+        reference front() { return items[0]; }
+        const_reference front() const { return items[0]; }
+        reference back() { return items[count - 1]; }
+        const_reference back() const { return items[count - 1]; }
+
+        iterator begin() noexcept { return items; }
+        iterator end() noexcept { return items + count; }
+        const_iterator begin() const noexcept { return items; }
+        const_iterator end() const noexcept { return items + count; }
+        const_iterator cbegin() const noexcept { return items; }
+        const_iterator cend() const noexcept { return items + count; }
+
+        bool operator==(const static_vector& other) const {
+          if(count != other.count) return false;
+          for(size_type i = 0; i < count; i++) {
+            if(!(items[i] == other.items[i])) return false;
+          }
+          return true;
+        }
+        bool operator!=(const static_vector& other) const { return !(*this == other); }
+
+    private:
+        T items[CAPACITY];
+        size_type count;
+};
+
+#endif // SEEED_BOT_STATIC_VECTOR_HPP
@@ -39,6 +39,8 @@ then
 
 	echo "-->GCC for Cadmium Desktop"
 	sudo apt-get -y install libboost-all-dev
+	echo "-->Google Benchmark for the desktop benchmarks (make bench)"
+	sudo apt-get -y install libbenchmark-dev
 	sudo add-apt-repository -y ppa:jonathonf/gcc-7.1
 	sudo apt-get update
 	sudo apt-get -y install gcc-7 g++-7
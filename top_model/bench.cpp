@@ -0,0 +1,322 @@
+/**
+* ARSLab - Carleton University
+*
+* Benchmarks:
+* Desktop micro-benchmarks (Google Benchmark) for the controller models and the runner:
+*   - LightBot and SeeedBotDriver external transition, output and internal transition
+*   - runner::run_until throughput on synthetic traces of 10^3 to 10^7 samples per sensor,
+*     reported as simulated events per second
+*   - logger overhead: not_logger, log_all to a discarding stream and log_all to the ring logger
+*   - time arithmetic of NDTime against TickTime (utilities/tick_time.hpp)
+*
+*   make bench   (results in bench_results/<commit>.json)
+*
+* The synthetic traces are binary traces (utilities/binary_trace.hpp) written once to bench_traces/,
+* so the runner figures do not include parsing the text trace format.
+*/
+
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <streambuf>
+#include <string>
+
+#include <sys/stat.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cadmium/modeling/coupling.hpp>
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/concept/coupled_model_assert.hpp>
+#include <cadmium/modeling/dynamic_coupled.hpp>
+#include <cadmium/modeling/dynamic_atomic.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/tuple_to_ostream.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#include <NDTime.hpp>
+
+#include "../atomics/lightBot.hpp"
+#include "../atomics/seeedBotDriver.hpp"
+#include "../atomics/binaryTraceInput.hpp"
+#include "../utilities/binary_trace.hpp"
+#include "../utilities/ring_logger.hpp"
+#include "../utilities/tick_time.hpp"
+#include "../utilities/time_conversion.hpp"
+
+using namespace std;
+
+using TIME = NDTime;
+
+/***************** Controllers *****************/
+
+// Message bags holding one value on a sensor port.
+template<typename MODEL, typename PORT>
+static typename cadmium::make_message_bags<typename MODEL::input_ports>::type sensor_bags(typename PORT::message_type value) {
+  typename cadmium::make_message_bags<typename MODEL::input_ports>::type bags;
+  cadmium::get_messages<PORT>(bags).push_back(value);
+  return bags;
+}
+
+template<typename MODEL, typename PORT>
+static void external_transitions(benchmark::State& st, typename PORT::message_type low, typename PORT::message_type high) {
+  MODEL model(st.range(0) != 0);
+  const auto low_bags = sensor_bags<MODEL, PORT>(low);
+  const auto high_bags = sensor_bags<MODEL, PORT>(high);
+  const TIME e("00:00:00:001");
+  bool toggle = false;
+  for(auto _ : st) {
+    model.external_transition(e, toggle ? high_bags : low_bags);
+    model.internal_transition();
+    toggle = !toggle;
+  }
+  benchmark::DoNotOptimize(model.state);
+  st.SetItemsProcessed(st.iterations());
+}
+
+template<typename MODEL, typename PORT>
+static void outputs(benchmark::State& st, typename PORT::message_type value) {
+  MODEL model(false); // all four motor ports pending
+  model.external_transition(TIME("00:00:00:001"), sensor_bags<MODEL, PORT>(value));
+  for(auto _ : st) {
+    benchmark::DoNotOptimize(model.output());
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+
+template<typename MODEL>
+static void internal_transitions(benchmark::State& st) {
+  MODEL model;
+  for(auto _ : st) {
+    model.internal_transition();
+    benchmark::DoNotOptimize(model.time_advance());
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+
+// External transition followed by the internal one, the sensor value alternating. Argument: change detection off/on.
+static void BM_LightBot_ExternalTransition(benchmark::State& st) {
+  external_transitions<LightBot<TIME>, lightBot_defs::rightLightSens>(st, 0.2f, 0.8f);
+}
+static void BM_SeeedBotDriver_ExternalTransition(benchmark::State& st) {
+  external_transitions<SeeedBotDriver<TIME>, seeedBotDriver_defs::rightIR>(st, false, true);
+}
+static void BM_LightBot_Output(benchmark::State& st) {
+  outputs<LightBot<TIME>, lightBot_defs::rightLightSens>(st, 0.8f);
+}
+static void BM_SeeedBotDriver_Output(benchmark::State& st) {
+  outputs<SeeedBotDriver<TIME>, seeedBotDriver_defs::rightIR>(st, false);
+}
+static void BM_LightBot_InternalTransition(benchmark::State& st) {
+  internal_transitions<LightBot<TIME>>(st);
+}
+static void BM_SeeedBotDriver_InternalTransition(benchmark::State& st) {
+  internal_transitions<SeeedBotDriver<TIME>>(st);
+}
+
+BENCHMARK(BM_LightBot_ExternalTransition)->Arg(0)->Arg(1);
+BENCHMARK(BM_SeeedBotDriver_ExternalTransition)->Arg(0)->Arg(1);
+BENCHMARK(BM_LightBot_Output);
+BENCHMARK(BM_SeeedBotDriver_Output);
+BENCHMARK(BM_LightBot_InternalTransition);
+BENCHMARK(BM_SeeedBotDriver_InternalTransition);
+
+/***************** Time *****************/
+
+// The zero time advance of the controllers, as it was written before (parsed) and now (default constructed).
+template<typename T>
+static void BM_Time_Parse(benchmark::State& st) {
+  for(auto _ : st) {
+    benchmark::DoNotOptimize(T("00:00:00"));
+  }
+}
+template<typename T>
+static void BM_Time_Zero(benchmark::State& st) {
+  for(auto _ : st) {
+    benchmark::DoNotOptimize(T());
+  }
+}
+
+// What the runner does per step: next event time of every model, the minimum, and the elapsed time.
+template<typename T>
+static void BM_Time_Schedule(benchmark::State& st) {
+  T last[4] = {T({0, 0, 0, 1}), T({0, 0, 0, 2}), T({0, 0, 0, 3}), T({0, 0, 0, 4})};
+  const T advance[4] = {T({0, 0, 0, 1}), std::numeric_limits<T>::infinity(), T({0, 0, 0, 0, 500}), T({0, 0, 0, 2})};
+  T now;
+  for(auto _ : st) {
+    T next = std::numeric_limits<T>::infinity();
+    for(int i = 0; i < 4; i++) {
+      const T candidate = last[i] + advance[i];
+      if(candidate < next) next = candidate;
+    }
+    const T elapsed = next - now;
+    last[0] = now = next;
+    benchmark::DoNotOptimize(elapsed);
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_Time_Parse, NDTime);
+BENCHMARK_TEMPLATE(BM_Time_Parse, TickTime);
+BENCHMARK_TEMPLATE(BM_Time_Zero, NDTime);
+BENCHMARK_TEMPLATE(BM_Time_Zero, TickTime);
+BENCHMARK_TEMPLATE(BM_Time_Schedule, NDTime);
+BENCHMARK_TEMPLATE(BM_Time_Schedule, TickTime);
+
+// Internal transition and time advance of LightBot with each time type.
+static void BM_LightBot_InternalTransition_TickTime(benchmark::State& st) {
+  internal_transitions<LightBot<TickTime>>(st);
+}
+BENCHMARK(BM_LightBot_InternalTransition_TickTime);
+
+/***************** Runner *****************/
+
+static const char* trace_dir = "./bench_traces";
+
+struct trace_set {
+  string centerIR;
+  string leftLightSens;
+  string rightLightSens;
+  long long end_us;
+};
+
+// Three binary traces of n samples each, 1 ms apart, generated once per n.
+static const trace_set& synthetic_traces(long long n) {
+  static map<long long, trace_set> sets;
+  auto found = sets.find(n);
+  if(found != sets.end()) return found->second;
+
+  mkdir(trace_dir, 0755);
+  const string prefix = string(trace_dir) + "/" + to_string(n) + "_";
+  trace_set set = {prefix + "A2_CenterIR_In.sbt", prefix + "A4_leftLightSens_In.sbt", prefix + "A5_rightLightSens_In.sbt", n * 1000 + 1000};
+
+  mt19937 rng(n);
+  uniform_real_distribution<float> light(0, 1);
+  {
+    ofstream out(set.centerIR, ios::binary | ios::trunc);
+    BinaryTraceWriter<bool> writer(out);
+    for(long long i = 1; i <= n; i++) writer.write(i * 1000, rng() % 64 != 0); // the ground is rarely lost
+    writer.finish();
+  }
+  {
+    ofstream left(set.leftLightSens, ios::binary | ios::trunc);
+    ofstream right(set.rightLightSens, ios::binary | ios::trunc);
+    BinaryTraceWriter<float> left_writer(left), right_writer(right);
+    for(long long i = 1; i <= n; i++) {
+      left_writer.write(i * 1000, light(rng));
+      right_writer.write(i * 1000, light(rng));
+    }
+    left_writer.finish();
+    right_writer.finish();
+  }
+  return sets[n] = set;
+}
+
+// LightBot fed by the three traces. The motor ports are left unconnected.
+static shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> make_top(const trace_set& traces) {
+  using AtomicModelPtr=std::shared_ptr<cadmium::dynamic::modeling::model>;
+
+  AtomicModelPtr lightBot = cadmium::dynamic::translate::make_dynamic_atomic_model<LightBot, TIME>("lightBot");
+  AtomicModelPtr centerIR = cadmium::dynamic::translate::make_dynamic_atomic_model<BinaryDigitalInput, TIME>("centerIR", traces.centerIR.c_str());
+  AtomicModelPtr rightLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<BinaryAnalogInput, TIME>("rightLightSens", traces.rightLightSens.c_str());
+  AtomicModelPtr leftLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<BinaryAnalogInput, TIME>("leftLightSens", traces.leftLightSens.c_str());
+
+  cadmium::dynamic::modeling::Ports iports_TOP = {};
+  cadmium::dynamic::modeling::Ports oports_TOP = {};
+  cadmium::dynamic::modeling::Models submodels_TOP = {rightLightSens, leftLightSens, lightBot, centerIR};
+  cadmium::dynamic::modeling::EICs eics_TOP = {};
+  cadmium::dynamic::modeling::EOCs eocs_TOP = {};
+  cadmium::dynamic::modeling::ICs ics_TOP = {
+     cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::rightLightSens>("rightLightSens", "lightBot"),
+     cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::leftLightSens>("leftLightSens", "lightBot"),
+     cadmium::dynamic::translate::make_IC<digitalInput_defs::out, lightBot_defs::centerIR>("centerIR", "lightBot")
+  };
+  return std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
+   "TOP",
+   submodels_TOP,
+   iports_TOP,
+   oports_TOP,
+   eics_TOP,
+   eocs_TOP,
+   ics_TOP
+   );
+}
+
+// Model construction and runner setup are not timed, only run_until.
+template<typename LOGGER>
+static void run_traces(benchmark::State& st) {
+  const long long n = st.range(0);
+  const trace_set& traces = synthetic_traces(n);
+  const TIME until = from_microseconds<TIME>(traces.end_us);
+  for(auto _ : st) {
+    st.PauseTiming();
+    auto TOP = make_top(traces);
+    cadmium::dynamic::engine::runner<TIME, LOGGER> r(TOP, {0});
+    st.ResumeTiming();
+    r.run_until(until);
+  }
+  // Each sample is one output of an input model and one external transition of LightBot.
+  st.counters["events/s"] = benchmark::Counter((double) 3 * n, benchmark::Counter::kIsIterationInvariantRate);
+  st.SetLabel(to_string(3 * n) + " input samples");
+}
+
+static void BM_RunUntil(benchmark::State& st) {
+  run_traces<cadmium::logger::not_logger>(st);
+}
+BENCHMARK(BM_RunUntil)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
+
+/***************** Loggers *****************/
+
+// Accepts and discards everything, so only the cost of formatting the log is measured.
+class null_buffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+struct null_sink_provider{
+  static std::ostream& sink(){
+    static null_buffer buffer;
+    static std::ostream os(&buffer);
+    return os;
+  }
+};
+
+template<typename SINK>
+struct all_loggers {
+  using info=cadmium::logger::logger<cadmium::logger::logger_info, cadmium::dynamic::logger::formatter<TIME>, SINK>;
+  using debug=cadmium::logger::logger<cadmium::logger::logger_debug, cadmium::dynamic::logger::formatter<TIME>, SINK>;
+  using state=cadmium::logger::logger<cadmium::logger::logger_state, cadmium::dynamic::logger::formatter<TIME>, SINK>;
+  using log_messages=cadmium::logger::logger<cadmium::logger::logger_messages, cadmium::dynamic::logger::formatter<TIME>, SINK>;
+  using routing=cadmium::logger::logger<cadmium::logger::logger_message_routing, cadmium::dynamic::logger::formatter<TIME>, SINK>;
+  using global_time=cadmium::logger::logger<cadmium::logger::logger_global_time, cadmium::dynamic::logger::formatter<TIME>, SINK>;
+  using local_time=cadmium::logger::logger<cadmium::logger::logger_local_time, cadmium::dynamic::logger::formatter<TIME>, SINK>;
+  using log_all=cadmium::logger::multilogger<info, debug, state, log_messages, routing, global_time, local_time>;
+};
+
+static void BM_Logger_NotLogger(benchmark::State& st) {
+  run_traces<cadmium::logger::not_logger>(st);
+}
+
+static void BM_Logger_LogAllDiscard(benchmark::State& st) {
+  run_traces<all_loggers<null_sink_provider>::log_all>(st);
+}
+
+// The ring is drained to a discarding stream; records that do not fit are counted.
+static void BM_Logger_LogAllRing(benchmark::State& st) {
+  RingLogDrain log_drain(ring_log_buffer(), null_sink_provider::sink());
+  log_drain.start();
+  const unsigned long overflows = ring_log_buffer().overflows();
+  run_traces<all_loggers<ring_sink_provider>::log_all>(st);
+  log_drain.stop();
+  st.counters["dropped_lines"] = (double) (ring_log_buffer().overflows() - overflows);
+}
+
+BENCHMARK(BM_Logger_NotLogger)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Logger_LogAllDiscard)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Logger_LogAllRing)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,253 @@
+/**
+* ARSLab - Carleton University
+*
+* Closed Loop:
+* Runs a light-seeking controller against the simulated robot plant (utilities/robot_fleet.hpp)
+* instead of recorded traces, so the light readings follow what the controller does with the
+* motors. Every fleet size given is scattered over the arena and run for the same time; each
+* step reads the sensors of every robot, runs the policy decision and motor command, then steps
+* the whole fleet at once. One line per fleet size: how many robots came within 0.2 m of the
+* light and their mean time to get there, how many ended stopped at the arena edge, their mean
+* final distance to the light, the motor port events per robot and second (ports whose value
+* changed, as sent with change detection), and the time spent in the plant and in the controller.
+*
+*   ./CLOSED_LOOP [-c light|steer] [-n 1,10,100,1000,10000] [-t 60] [-s seed] [-h threshold]
+*                 [-k kp,ki,deadband,levels] [--devs]
+*
+* -c light is LightBot (atomics/lightBot.hpp, -h sets its threshold), -c steer is SteeringBot
+* (atomics/steeringBot.hpp, -k sets its gains).
+*
+* --devs also runs robot 0 of the first fleet through the Cadmium models (the controller and
+* RobotPlant) and compares its final pose with the batch loop, which checks that the batch
+* loop drives the plant the way the DEVS controller does.
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cadmium/modeling/coupling.hpp>
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/concept/coupled_model_assert.hpp>
+#include <cadmium/modeling/dynamic_coupled.hpp>
+#include <cadmium/modeling/dynamic_atomic.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#include <NDTime.hpp>
+
+#include "../atomics/lightBot.hpp"
+#include "../atomics/steeringBot.hpp"
+#include "../atomics/robotPlant.hpp"
+#include "../utilities/robot_fleet.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+// Controller step, also the period at which RobotPlant sends the sensors.
+static const long long STEP_US = 10000;
+// A robot that came this close to the light has found it (m).
+static const float REACHED = 0.2f;
+
+struct loop_result {
+  size_t reached;
+  double mean_reach_s;
+  size_t stopped;
+  double mean_distance;
+  unsigned long long motor_events;
+  double plant_s;
+  double controller_s;
+};
+
+static double seconds_since(hclock::time_point start) {
+  return chrono::duration_cast<chrono::duration<double>>(hclock::now() - start).count();
+}
+
+// Sensor readings of robot i, as the policy's read() would store them.
+static void sense(const light_policy&, light_policy::sensor_state& s, const robot_fleet& fleet, size_t i) {
+  s = {fleet.right_light[i], fleet.left_light[i], fleet.ground[i] == 0};
+}
+
+static void sense(const steering_policy& policy, steering_policy::sensor_state& s, const robot_fleet& fleet, size_t i) {
+  policy.light(s, fleet.left_light[i], fleet.right_light[i]);
+  s.centerIR = fleet.ground[i] == 0;
+}
+
+static unsigned changed_ports(const motor_command& a, const motor_command& b) {
+  return (a.rightMotor1 != b.rightMotor1) + (a.rightMotor2 != b.rightMotor2) + (a.leftMotor1 != b.leftMotor1) + (a.leftMotor2 != b.leftMotor2);
+}
+
+// Runs the policy on every robot of the fleet for steps controller periods.
+template<typename POLICY>
+static loop_result run_fleet(robot_fleet& fleet, const POLICY& policy, long long steps) {
+  const size_t n = fleet.size();
+  const float dt = STEP_US * 1e-6f;
+  const plant_params& p = fleet.params();
+  const float reached2 = REACHED * REACHED;
+  vector<long long> reached(n, -1);
+  vector<typename POLICY::sensor_state> sensors(n, typename POLICY::sensor_state());
+  vector<motor_command> sent(n);
+  loop_result result = {0, 0, 0, 0, 0, 0, 0};
+  for(long long k = 0; k < steps; k++) {
+    auto start = hclock::now();
+    for(size_t i = 0; i < n; i++) {
+      const float dx = fleet.x[i] - p.light_x;
+      const float dy = fleet.y[i] - p.light_y;
+      if(reached[i] < 0 && (dx * dx + dy * dy) < reached2) reached[i] = k;
+      typename POLICY::sensor_state& s = sensors[i];
+      sense(policy, s, fleet, i);
+      const motor_command m = policy.command(policy.decide(s), s);
+      // The first command is sent on every port.
+      result.motor_events += k == 0 ? 4 : changed_ports(m, sent[i]);
+      sent[i] = m;
+      fleet.set_motors(i, m.rightMotor1, m.rightMotor2, m.leftMotor1, m.leftMotor2);
+    }
+    auto middle = hclock::now();
+    fleet.step(dt);
+    result.controller_s += chrono::duration_cast<chrono::duration<double>>(middle - start).count();
+    result.plant_s += seconds_since(middle);
+  }
+  for(size_t i = 0; i < n; i++) {
+    result.mean_distance += hypot(fleet.x[i] - p.light_x, fleet.y[i] - p.light_y);
+    if(reached[i] >= 0) {
+      result.reached++;
+      result.mean_reach_s += reached[i] * STEP_US * 1e-6;
+    }
+    if(!fleet.ground[i]) result.stopped++;
+  }
+  result.mean_distance /= n;
+  if(result.reached) result.mean_reach_s /= result.reached;
+  return result;
+}
+
+// One robot through the controller and RobotPlant, moving the robot of fleet.
+template<template<typename> class CONTROLLER, typename... ARGs>
+static void run_devs(robot_fleet* fleet, long long steps, ARGs... controllerArgs) {
+  using AtomicModelPtr=std::shared_ptr<cadmium::dynamic::modeling::model>;
+  using CoupledModelPtr=std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>>;
+
+  AtomicModelPtr robot = cadmium::dynamic::translate::make_dynamic_atomic_model<RobotPlant, TIME>("robot", fleet, STEP_US);
+  AtomicModelPtr lightBot = cadmium::dynamic::translate::make_dynamic_atomic_model<CONTROLLER, TIME>("lightBot", true, controllerArgs...);
+
+  cadmium::dynamic::modeling::Models submodels_TOP = {robot, lightBot};
+  cadmium::dynamic::modeling::ICs ics_TOP = {
+     cadmium::dynamic::translate::make_IC<robotPlant_defs::lightPair, lightBot_defs::lightPair>("robot", "lightBot"),
+     cadmium::dynamic::translate::make_IC<robotPlant_defs::centerIR, lightBot_defs::centerIR>("robot", "lightBot"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor1, robotPlant_defs::rightMotor1>("lightBot", "robot"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor2, robotPlant_defs::rightMotor2>("lightBot", "robot"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor1, robotPlant_defs::leftMotor1>("lightBot", "robot"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor2, robotPlant_defs::leftMotor2>("lightBot", "robot")
+  };
+  cadmium::dynamic::modeling::Ports iports_TOP = {};
+  cadmium::dynamic::modeling::Ports oports_TOP = {};
+  cadmium::dynamic::modeling::EICs eics_TOP = {};
+  cadmium::dynamic::modeling::EOCs eocs_TOP = {};
+  CoupledModelPtr TOP = std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
+   "TOP",
+   submodels_TOP,
+   iports_TOP,
+   oports_TOP,
+   eics_TOP,
+   eocs_TOP,
+   ics_TOP
+   );
+
+  cadmium::dynamic::engine::runner<TIME, cadmium::logger::not_logger> r(TOP, {0});
+  // Just past the last plant step, whose sensor values are not used.
+  r.run_until(from_microseconds<TIME>(steps * STEP_US + 1));
+}
+
+static vector<size_t> parse_sizes(const string& list) {
+  vector<size_t> sizes;
+  stringstream ss(list);
+  string item;
+  while(getline(ss, item, ',')) {
+    if(!item.empty()) sizes.push_back(strtoul(item.c_str(), nullptr, 10));
+  }
+  return sizes;
+}
+
+static void usage() {
+  cerr << "usage: CLOSED_LOOP [-c light|steer] [-n 1,10,100,1000,10000] [-t 60] [-s seed] [-h threshold]" << endl
+       << "                   [-k kp,ki,deadband,levels] [--devs]" << endl;
+  exit(2);
+}
+
+static bool parse_gains(const char* text, steering_gains& gains) {
+  return sscanf(text, "%f,%f,%f,%u", &gains.kp, &gains.ki, &gains.deadband, &gains.levels) == 4;
+}
+
+template<typename POLICY>
+static void run_sizes(const vector<size_t>& sizes, const POLICY& policy, unsigned long long seed, long long steps) {
+  printf("%8s %8s %8s %8s %10s %10s %10s %10s %12s\n", "robots", "reached", "reach s", "stopped", "mean dist", "events/s",
+         "plant s", "ctrl s", "robot-steps/s");
+  for(size_t n : sizes) {
+    robot_fleet fleet(n);
+    fleet.scatter(seed);
+    const loop_result r = run_fleet(fleet, policy, steps);
+    const double total = r.plant_s + r.controller_s;
+    printf("%8zu %8zu %8.2f %8zu %10.3f %10.2f %10.3f %10.3f %12.3g\n", n, r.reached, r.mean_reach_s, r.stopped, r.mean_distance,
+           r.motor_events / (n * steps * STEP_US * 1e-6), r.plant_s, r.controller_s, total > 0 ? n * steps / total : 0.0);
+  }
+}
+
+// Robot 0 of the first fleet size through the batch loop and through the DEVS models.
+template<template<typename> class CONTROLLER, typename POLICY, typename... ARGs>
+static void check_devs(size_t size, const POLICY& policy, unsigned long long seed, long long steps, ARGs... controllerArgs) {
+  robot_fleet fleet(size);
+  fleet.scatter(seed);
+  robot_fleet single(1);
+  single.set_pose(0, fleet.x[0], fleet.y[0], fleet.heading[0]);
+  run_fleet(fleet, policy, steps);
+  auto start = hclock::now();
+  run_devs<CONTROLLER>(&single, steps, controllerArgs...);
+  const double elapsed = seconds_since(start);
+  printf("DEVS robot 0: (%.4f, %.4f) batch: (%.4f, %.4f), %.3f s\n", single.x[0], single.y[0],
+         fleet.x[0], fleet.y[0], elapsed);
+}
+
+int main(int argc, char ** argv) {
+  vector<size_t> sizes = {1, 10, 100, 1000, 10000};
+  double seconds = 60;
+  unsigned long long seed = 1;
+  float threshold = 0.1f;
+  steering_gains gains = default_steering;
+  string controller = "light";
+  bool devs = false;
+  for(int i = 1; i < argc; i++) {
+    const string arg = argv[i];
+    if(arg == "--devs") { devs = true; continue; }
+    if(i + 1 >= argc) usage();
+    if(arg == "-c") controller = argv[++i];
+    else if(arg == "-k") { if(!parse_gains(argv[++i], gains)) usage(); }
+    else if(arg == "-n") sizes = parse_sizes(argv[++i]);
+    else if(arg == "-t") seconds = atof(argv[++i]);
+    else if(arg == "-s") seed = strtoull(argv[++i], nullptr, 10);
+    else if(arg == "-h") threshold = atof(argv[++i]);
+    else usage();
+  }
+  if(sizes.empty() || seconds <= 0 || (controller != "light" && controller != "steer")) usage();
+
+  const long long steps = (long long) (seconds * 1e6 / STEP_US);
+
+  if(controller == "light") {
+    const light_policy policy(threshold);
+    run_sizes(sizes, policy, seed, steps);
+    if(devs) check_devs<LightBot>(sizes[0], policy, seed, steps, threshold);
+  } else {
+    const steering_policy policy(gains);
+    run_sizes(sizes, policy, seed, steps);
+    if(devs) check_devs<SteeringBot>(sizes[0], policy, seed, steps, gains);
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+#!/bin/sh
+# Compares the dynamic (main.cpp) and static (main_static.cpp) top models.
+#   Flash/RAM: from the ELF files of "make embedded" and "make embedded_static".
+#   Time per event: desktop runs of both top models without logging (SEEED_BOT_TOP_NOLOG,
+#   main.cpp built with -DNO_LOGS, and SEEED_BOT_TOP_STATIC) over a synthetic trace with a
+#   light sample every millisecond for the 10 simulated minutes. Only run_until is timed
+#   ("Run took"), divided by the number of input samples.
+# The report is also written to compare_builds_report.txt.
+# usage: ./compare_builds.sh <dynamic build dir> <static build dir> [runs]
+
+DYNAMIC_DIR=$1
+STATIC_DIR=$2
+RUNS=${3:-5}
+HERE=$(pwd)
+REPORT=$HERE/compare_builds_report.txt
+
+{
+echo "### Flash / RAM (bytes) ###"
+printf "%-10s %10s %10s\n" "model" "flash" "ram"
+for pair in "dynamic:$DYNAMIC_DIR" "static:$STATIC_DIR"; do
+    name=${pair%%:*}
+    elf=$(ls "${pair#*:}"/*.elf 2>/dev/null | head -n 1)
+    if [ -z "$elf" ]; then
+        printf "%-10s %21s\n" "$name" "no ELF, run make embedded / embedded_static"
+        continue
+    fi
+    arm-none-eabi-size "$elf" | awk -v n="$name" 'NR == 2 { printf "%-10s %10d %10d\n", n, $1 + $2, $2 + $3 }'
+done
+
+# Synthetic trace: both light sensors every ms, crossing each other every 100 ms so LightBot
+# keeps turning, and the center IR on the ground for the whole run.
+TRACE_DIR=$(mktemp -d)
+mkdir -p "$TRACE_DIR/inputs" "$TRACE_DIR/outputs"
+echo "00:00:00:000 1" > "$TRACE_DIR/inputs/A2_CenterIR_In.txt"
+for pin in A4_leftLightSens A5_rightLightSens; do
+    awk -v pin=$pin 'BEGIN {
+        for (ms = 0; ms < 600000; ms++) {
+            high = (int(ms / 100) % 2 == 0) == (pin == "A4_leftLightSens")
+            printf "%02d:%02d:%02d:%03d %s\n", ms / 3600000, (ms / 60000) % 60, (ms / 1000) % 60, ms % 1000, high ? "0.6" : "0.5"
+        }
+    }' > "$TRACE_DIR/inputs/${pin}_In.txt"
+done
+events=$(cat "$TRACE_DIR"/inputs/*.txt | grep -c .)
+
+echo ""
+echo "### Desktop run_until time per input event ($events input samples, best of $RUNS runs, no logging) ###"
+for exe in SEEED_BOT_TOP_NOLOG SEEED_BOT_TOP_STATIC; do
+    best=""
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        t=$(cd "$TRACE_DIR" && "$HERE/$exe" | sed -n 's/^Run took: \([0-9.e+-]*\) s$/\1/p')
+        best=$(echo "$t $best" | awk '{ if ($2 == "" || $1 < $2) print $1; else print $2 }')
+        i=$((i + 1))
+    done
+    echo "$exe $best $events" | awk '{ printf "%-22s %12.3f us/event\n", $1, $2 * 1e6 / $3 }'
+done
+rm -rf "$TRACE_DIR"
+} | tee "$REPORT"
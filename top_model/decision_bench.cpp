@@ -0,0 +1,258 @@
+/**
+* ARSLab - Carleton University
+*
+* Decision Benchmark:
+* Compares the table-driven SeeedBotDriver decision (line_policy::decisions and its motor
+* table) with the branching code it replaced, which tested the IR booleans and the light
+* reading with if/else and then switched on the DriveState to get the motor values.
+* First both are checked against each other for every sensor input, then the cost of one
+* sensor-to-motor decision is timed on a random sensor stream and on a line-following one.
+* Both versions are timed from the same raw sensor readings: the table version includes
+* packing them into bits (to_bits, with the light threshold test).
+* Before that, LineLightBot is checked against LightBot and SeeedBotDriver on one random
+* sensor stream with mode switches: after every event it must command what the controller of
+* the selected mode commands.
+*
+*   ./DECISION_BENCH [decisions]
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  #define DECISION_BENCH_TSC
+#endif
+
+#include "../atomics/seeedBotDriver.hpp"
+#include "../atomics/lineLightBot.hpp"
+#include "../utilities/cycle_clock.hpp"
+#include "../utilities/tick_time.hpp"
+
+using namespace std;
+
+struct legacy_inputs {
+  bool rightIR;
+  bool centerIR;
+  bool leftIR;
+  float light;
+};
+
+// The SeeedBotDriver decision and output switch before the table (SCARED_OF_THE_DARK enabled).
+static motor_command legacy_decision(const legacy_inputs& s) {
+  DriveState dir;
+  if((!(s.rightIR ^ s.leftIR ^ s.centerIR) && !(!s.rightIR && !s.leftIR && !s.centerIR)) || (s.rightIR && s.leftIR && s.centerIR)) {
+    dir = DriveState::stop;
+  } else if (s.rightIR) {
+    dir = DriveState::left;
+  } else if (s.leftIR) {
+    dir = DriveState::right;
+  } else {
+    dir = DriveState::straight;
+  }
+  if (s.light < 0.3) {
+    dir = DriveState::stop;
+  }
+
+  motor_command c;
+  switch(dir) {
+    case DriveState::right:
+      c = {0.5, 0, 1, 1};
+      break;
+    case DriveState::left:
+      c = {1, 1, 0.5, 0};
+      break;
+    case DriveState::straight:
+      c = {0.5, 0, 0.5, 0};
+      break;
+    default:
+      c = {0, 0, 0, 0};
+      break;
+  }
+  return c;
+}
+
+static motor_command table_decision(unsigned char bits) {
+  static const line_policy policy;
+  line_policy::sensor_state s;
+  s.bits = bits;
+  return policy.command(policy.decide(s), s);
+}
+
+static bool same(const motor_command& a, const motor_command& b) {
+  return a.rightMotor1 == b.rightMotor1 && a.rightMotor2 == b.rightMotor2 &&
+         a.leftMotor1 == b.leftMotor1 && a.leftMotor2 == b.leftMotor2;
+}
+
+static unsigned char to_bits(const legacy_inputs& s) {
+  return (s.leftIR ? line_policy::LEFT_IR : 0) | (s.centerIR ? line_policy::CENTER_IR : 0) |
+         (s.rightIR ? line_policy::RIGHT_IR : 0) | ((s.light < 0.3f) ? line_policy::DARK : 0);
+}
+
+// Every IR combination with light readings on both sides of, and at, the threshold.
+static int exhaustive_check() {
+  const float lights[] = {0.0f, 0.1f, 0.29999998f, 0.3f, 0.30000003f, 0.5f, 1.0f};
+  int failures = 0;
+  int cases = 0;
+  for(int ir = 0; ir < 8; ir++) {
+    for(float light : lights) {
+      const legacy_inputs s = {(ir & 4) != 0, (ir & 2) != 0, (ir & 1) != 0, light};
+      cases++;
+      if(!same(legacy_decision(s), table_decision(to_bits(s)))) {
+        fprintf(stderr, "Mismatch: rightIR %d centerIR %d leftIR %d light %.8f\n", s.rightIR, s.centerIR, s.leftIR, light);
+        failures++;
+      }
+    }
+  }
+  printf("exhaustive check: %d inputs, %d mismatches\n", cases, failures);
+  return failures;
+}
+
+template<typename MODEL>
+using input_bags = typename cadmium::make_message_bags<typename MODEL::input_ports>::type;
+
+// What a controller commands for its latest readings.
+template<typename MODEL>
+static motor_command decision(const MODEL& m) {
+  return m.policy.command(m.policy.decide(m.state.sensors), m.state.sensors);
+}
+
+// Each event goes to LineLightBot and to the single controller(s) that read that sensor; a
+// mode change goes to LineLightBot only and must switch it to the other one's command at once.
+static int mode_switch_check(int events) {
+  LineLightBot<TickTime> both;
+  LightBot<TickTime> light;
+  SeeedBotDriver<TickTime> line;
+  mt19937 rng(3);
+  bool lineMode = false;
+  int switches = 0;
+  int failures = 0;
+  for(int i = 0; i < events; i++) {
+    input_bags<LineLightBot<TickTime>> bothBags;
+    input_bags<LightBot<TickTime>> lightBags;
+    input_bags<SeeedBotDriver<TickTime>> lineBags;
+    bool toLight = false;
+    bool toLine = false;
+    const unsigned r = rng();
+    const bool level = (r & 8) != 0;
+    switch(r % 5) {
+      case 0: {
+        const light_pair pair = {(float) (rng() % 101) / 100, (float) (rng() % 101) / 100};
+        cadmium::get_messages<lightBot_defs::lightPair>(bothBags).push_back(pair);
+        cadmium::get_messages<lightBot_defs::lightPair>(lightBags).push_back(pair);
+        toLight = true;
+        break;
+      }
+      case 1:
+        cadmium::get_messages<lightBot_defs::centerIR>(bothBags).push_back(level);
+        cadmium::get_messages<seeedBotDriver_defs::centerIR>(bothBags).push_back(level);
+        cadmium::get_messages<lightBot_defs::centerIR>(lightBags).push_back(level);
+        cadmium::get_messages<seeedBotDriver_defs::centerIR>(lineBags).push_back(level);
+        toLight = toLine = true;
+        break;
+      case 2:
+        cadmium::get_messages<seeedBotDriver_defs::leftIR>(bothBags).push_back(level);
+        cadmium::get_messages<seeedBotDriver_defs::leftIR>(lineBags).push_back(level);
+        toLine = true;
+        break;
+      case 3:
+        cadmium::get_messages<seeedBotDriver_defs::rightIR>(bothBags).push_back(level);
+        cadmium::get_messages<seeedBotDriver_defs::rightIR>(lineBags).push_back(level);
+        toLine = true;
+        break;
+      default:
+        lineMode = !lineMode;
+        switches++;
+        cadmium::get_messages<controller_defs::mode>(bothBags).push_back(lineMode);
+        break;
+    }
+    both.external_transition(TickTime(), bothBags);
+    both.internal_transition();
+    if(toLight) {
+      light.external_transition(TickTime(), lightBags);
+      light.internal_transition();
+    }
+    if(toLine) {
+      line.external_transition(TickTime(), lineBags);
+      line.internal_transition();
+    }
+    const motor_command expected = lineMode ? decision(line) : decision(light);
+    if(!same(both.state.command, expected)) {
+      if(failures == 0) fprintf(stderr, "Mismatch at event %d (%s mode)\n", i, lineMode ? "line" : "light");
+      failures++;
+    }
+  }
+  printf("mode switch check: %d events, %d mode switches, %d mismatches\n", events, switches, failures);
+  return failures;
+}
+
+static uint64_t timestamp() {
+  #ifdef DECISION_BENCH_TSC
+    return __rdtsc();
+  #else
+    return cycle_clock::now();
+  #endif
+}
+
+// Sums the motor values so the decisions cannot be optimized away. inputs.size() is a power of two.
+template<typename INPUT, typename DECISION>
+static void run(const char* name, const vector<INPUT>& inputs, long long decisions, DECISION decision) {
+  const size_t mask = inputs.size() - 1;
+  float checksum = 0;
+  const uint64_t start = timestamp();
+  for(long long i = 0; i < decisions; i++) {
+    const motor_command c = decision(inputs[i & mask]);
+    checksum += c.rightMotor1 + c.rightMotor2 + c.leftMotor1 + c.leftMotor2;
+  }
+  const uint64_t end = timestamp();
+  #ifdef DECISION_BENCH_TSC
+    printf("%-26s %8.2f TSC cycles/decision  (checksum %.0f)\n", name, (double) (end - start) / decisions, checksum);
+  #else
+    printf("%-26s %8.2f ns/decision  (checksum %.0f)\n", name, (double) cycle_clock::to_ns(end - start) / decisions, checksum);
+  #endif
+}
+
+// Random sensors: no pattern for the branch predictor.
+static vector<legacy_inputs> random_stream(size_t n) {
+  mt19937 rng(1);
+  vector<legacy_inputs> v(n);
+  for(auto& s : v) {
+    const unsigned r = rng();
+    s = {(r & 1) != 0, (r & 2) != 0, (r & 4) != 0, (r & 8) ? 0.8f : 0.1f};
+  }
+  return v;
+}
+
+// Line following: the line drifts slowly under the sensors and it is almost always light.
+static vector<legacy_inputs> line_stream(size_t n) {
+  mt19937 rng(2);
+  vector<legacy_inputs> v(n);
+  int position = 0; // -1 left sensor, 0 center, 1 right
+  for(auto& s : v) {
+    if(rng() % 32 == 0) position = (int) (rng() % 3) - 1;
+    s = {position == 1, position == 0, position == -1, (rng() % 1024 == 0) ? 0.1f : 0.8f};
+  }
+  return v;
+}
+
+int main(int argc, char ** argv) {
+  const long long decisions = argc > 1 ? atoll(argv[1]) : 100000000;
+
+  if(exhaustive_check() != 0 || mode_switch_check(100000) != 0) {
+    return 1;
+  }
+
+  cycle_clock::init();
+  struct stream { const char* name; vector<legacy_inputs> inputs; };
+  const stream streams[] = {{"random", random_stream(4096)}, {"line following", line_stream(4096)}};
+
+  for(const auto& st : streams) {
+    printf("%s sensors:\n", st.name);
+    run("  branching", st.inputs, decisions, legacy_decision);
+    run("  table", st.inputs, decisions, [](const legacy_inputs& s) { return table_decision(to_bits(s)); });
+  }
+  return 0;
+}
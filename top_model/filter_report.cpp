@@ -0,0 +1,199 @@
+/**
+* ARSLab - Carleton University
+*
+* Filter Report:
+* Replays one set of recorded sensor traces twice through LightBot: with every light sample
+* (no filtering) and with the light sensor filters (atomics/filteredInput.hpp). It prints the
+* event counts of both runs and checks the steering decisions did not change: time spent in
+* each direction, and for how much of the run both runs were driving in the same direction.
+*
+*   ./FILTER_REPORT [scenario dir] [-c input_filters.txt] [-u 00:10:00:000]
+*
+* The scenario dir holds the three input traces (same names as inputs/, the default). Without
+* -c both light sensors use a 0.01 deadband. The exit code is 1 when the steering of the two
+* runs differs, so a setting can be checked before it goes in input_filters.txt or main.cpp
+* (which uses no filtering by default).
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cadmium/modeling/coupling.hpp>
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/concept/coupled_model_assert.hpp>
+#include <cadmium/modeling/dynamic_coupled.hpp>
+#include <cadmium/modeling/dynamic_atomic.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#include <NDTime.hpp>
+
+#include <cadmium/real_time/arm_mbed/io/digitalInput.hpp>
+#include <cadmium/real_time/arm_mbed/io/analogInput.hpp>
+
+#include "../atomics/lightBot.hpp"
+#include "../atomics/driveMonitor.hpp"
+#include "../atomics/filteredInput.hpp"
+#include "../utilities/time_conversion.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+template<typename T> using FilteredAnalogInput = filtered_input<AnalogInput>::model<T>;
+
+struct replay {
+  input_filter right;
+  input_filter left;
+  drive_metrics metrics;
+  vector<drive_change> history;
+  unsigned long samples[2]; // right, left
+  unsigned long sent[2];
+  double seconds;
+};
+
+static void run_replay(replay& run, const string& dir, const TIME& until) {
+  const string A2 = dir + "/A2_CenterIR_In.txt";
+  const string A4 = dir + "/A4_leftLightSens_In.txt";
+  const string A5 = dir + "/A5_rightLightSens_In.txt";
+
+  using AtomicModelPtr=std::shared_ptr<cadmium::dynamic::modeling::model>;
+  using CoupledModelPtr=std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>>;
+
+  input_filter_stats::reset();
+  run.metrics.history = &run.history;
+
+  AtomicModelPtr lightBot = cadmium::dynamic::translate::make_dynamic_atomic_model<LightBot, TIME>("lightBot");
+  AtomicModelPtr centerIR = cadmium::dynamic::translate::make_dynamic_atomic_model<DigitalInput, TIME>("centerIR", A2.c_str());
+  AtomicModelPtr rightLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<FilteredAnalogInput, TIME>("rightLightSens", instrumentation{"rightLightSens", {}, run.right}, A5.c_str());
+  AtomicModelPtr leftLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<FilteredAnalogInput, TIME>("leftLightSens", instrumentation{"leftLightSens", {}, run.left}, A4.c_str());
+  AtomicModelPtr monitor = cadmium::dynamic::translate::make_dynamic_atomic_model<DriveMonitor, TIME>("monitor", &run.metrics);
+
+  cadmium::dynamic::modeling::Ports iports_TOP = {};
+  cadmium::dynamic::modeling::Ports oports_TOP = {};
+  cadmium::dynamic::modeling::Models submodels_TOP = {rightLightSens, leftLightSens, lightBot, centerIR, monitor};
+  cadmium::dynamic::modeling::EICs eics_TOP = {};
+  cadmium::dynamic::modeling::EOCs eocs_TOP = {};
+  cadmium::dynamic::modeling::ICs ics_TOP = {
+     cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor1, driveMonitor_defs::rightMotor1>("lightBot","monitor"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor2, driveMonitor_defs::rightMotor2>("lightBot","monitor"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor1, driveMonitor_defs::leftMotor1>("lightBot","monitor"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor2, driveMonitor_defs::leftMotor2>("lightBot","monitor"),
+
+     cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::rightLightSens>("rightLightSens", "lightBot"),
+     cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::leftLightSens>("leftLightSens", "lightBot"),
+
+     cadmium::dynamic::translate::make_IC<digitalInput_defs::out, lightBot_defs::centerIR>("centerIR", "lightBot")
+  };
+  CoupledModelPtr TOP = std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
+   "TOP",
+   submodels_TOP,
+   iports_TOP,
+   oports_TOP,
+   eics_TOP,
+   eocs_TOP,
+   ics_TOP
+   );
+
+  auto start = hclock::now();
+  cadmium::dynamic::engine::runner<TIME, cadmium::logger::not_logger> r(TOP, {0});
+  r.run_until(until);
+  run.metrics.finish(to_microseconds(until));
+  run.seconds = chrono::duration_cast<chrono::duration<double>>(hclock::now() - start).count();
+
+  const char* names[2] = {"rightLightSens", "leftLightSens"};
+  for(int i = 0; i < 2; i++) {
+    const input_filter_stats* stats = input_filter_stats::get(names[i]);
+    run.samples[i] = stats ? stats->samples : 0;
+    run.sent[i] = stats ? stats->sent : 0;
+  }
+}
+
+// Time both runs drove in the same direction, and the first time they did not (-1 if never).
+static long long agreement(const vector<drive_change>& a, const vector<drive_change>& b, long long end_us, long long& first_divergence) {
+  DriveState dir_a = DriveState::stop, dir_b = DriveState::stop;
+  size_t i = 0, j = 0;
+  long long now = 0, same = 0;
+  first_divergence = -1;
+  while(now < end_us) {
+    while(i < a.size() && a[i].time_us <= now) dir_a = a[i++].dir;
+    while(j < b.size() && b[j].time_us <= now) dir_b = b[j++].dir;
+    long long next = end_us;
+    if(i < a.size() && a[i].time_us < next) next = a[i].time_us;
+    if(j < b.size() && b[j].time_us < next) next = b[j].time_us;
+    if(dir_a == dir_b) same += next - now;
+    else if(first_divergence < 0) first_divergence = now;
+    now = next;
+  }
+  return same;
+}
+
+static void usage() {
+  cerr << "usage: FILTER_REPORT [scenario dir] [-c input_filters.txt] [-u 00:10:00:000]" << endl;
+  exit(2);
+}
+
+int main(int argc, char ** argv) {
+  string dir = "./inputs";
+  string config;
+  string until_text = "00:10:00:000";
+  int i = 1;
+  if(i < argc && argv[i][0] != '-') dir = argv[i++];
+  for(; i < argc; i++) {
+    const string arg = argv[i];
+    if(i + 1 >= argc) usage();
+    if(arg == "-c") config = argv[++i];
+    else if(arg == "-u") until_text = argv[++i];
+    else usage();
+  }
+
+  replay raw, filtered;
+  raw.right = raw.left = no_input_filter;
+  filtered.right = filtered.left = {0.01, 1, 0};
+  if(!config.empty()) {
+    if(!load_input_filters(config.c_str(), "rightLightSens", filtered.right)) cerr << "No rightLightSens line in " << config << ", using the default" << endl;
+    if(!load_input_filters(config.c_str(), "leftLightSens", filtered.left)) cerr << "No leftLightSens line in " << config << ", using the default" << endl;
+  }
+
+  const TIME until(until_text);
+  run_replay(raw, dir, until);
+  run_replay(filtered, dir, until);
+
+  const long long end_us = to_microseconds(until);
+  long long first_divergence;
+  const long long same = agreement(raw.history, filtered.history, end_us, first_divergence);
+
+  printf("Replay of %s until %s\n", dir.c_str(), until_text.c_str());
+  printf("filters: right deadband %.4f decimation %u period %lld us, left deadband %.4f decimation %u period %lld us\n\n",
+         filtered.right.deadband, filtered.right.decimation, filtered.right.period_us,
+         filtered.left.deadband, filtered.left.decimation, filtered.left.period_us);
+  printf("%-28s %12s %12s %8s\n", "", "unfiltered", "filtered", "change");
+  auto row = [](const char* name, double before, double after) {
+    printf("%-28s %12.0f %12.0f %7.1f%%\n", name, before, after, before > 0 ? 100.0 * (after - before) / before : 0.0);
+  };
+  row("light samples read", raw.samples[0] + raw.samples[1], filtered.samples[0] + filtered.samples[1]);
+  row("rightLightSens events", raw.sent[0], filtered.sent[0]);
+  row("leftLightSens events", raw.sent[1], filtered.sent[1]);
+  row("LightBot input events", raw.sent[0] + raw.sent[1], filtered.sent[0] + filtered.sent[1]);
+  row("motor port messages", raw.metrics.commands, filtered.metrics.commands);
+  row("direction changes", raw.metrics.changes, filtered.metrics.changes);
+  const char* dirs[4] = {"time right (ms)", "time straight (ms)", "time left (ms)", "time stop (ms)"};
+  for(int d = 0; d < 4; d++) {
+    row(dirs[d], raw.metrics.time_us[d] / 1000.0, filtered.metrics.time_us[d] / 1000.0);
+  }
+  printf("%-28s %12.3f %12.3f\n\n", "wall time (s)", raw.seconds, filtered.seconds);
+
+  printf("Same direction for %.3f%% of the run", end_us > 0 ? 100.0 * same / end_us : 100.0);
+  if(first_divergence >= 0) {
+    printf(", first difference at %s\n", format_time_string(first_divergence).c_str());
+    return 1;
+  }
+  printf(", identical steering\n");
+  return 0;
+}
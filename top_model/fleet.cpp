@@ -0,0 +1,219 @@
+/**
+* ARSLab - Carleton University
+*
+* Fleet:
+* Scaling of the dynamic runner with the number of robots. For every fleet size, a TOP model
+* of N robots is built with utilities/fleet_model.hpp and run once on one runner and once
+* split over -j partitions run in parallel. Each robot is a controller, its inputs and a
+* DriveMonitor:
+*
+*   light  LightBot in closed loop with a RobotPlant (atomics/robotPlant.hpp), robots
+*          scattered over the arena
+*   line   SeeedBotDriver on three InterruptDigitalInput, each IR crossing a line at random
+*          times (mean period -p ms)
+*
+* One line per size and runner: build time, run time, robot-seconds simulated per second and
+* the wall time per robot and simulated step (10 ms). The drive metrics of the partitioned
+* run must match the single runner, which is checked.
+*
+*   ./SEEED_BOT_FLEET [-c light|line] [-n 1,10,100,1000,10000] [-j threads] [-u 00:00:10:000] [-p 200]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cadmium/modeling/coupling.hpp>
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/concept/coupled_model_assert.hpp>
+#include <cadmium/modeling/dynamic_coupled.hpp>
+#include <cadmium/modeling/dynamic_atomic.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#include <NDTime.hpp>
+
+#include <cadmium/real_time/arm_mbed/io/digitalInput.hpp>
+
+#include "../atomics/lightBot.hpp"
+#include "../atomics/seeedBotDriver.hpp"
+#include "../atomics/robotPlant.hpp"
+#include "../atomics/interruptDigitalInput.hpp"
+#include "../atomics/driveMonitor.hpp"
+#include "../utilities/fleet_model.hpp"
+#include "../utilities/robot_fleet.hpp"
+#include "../utilities/time_conversion.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+static const long long STEP_US = 10000;
+
+static double seconds_since(hclock::time_point start) {
+  return chrono::duration_cast<chrono::duration<double>>(hclock::now() - start).count();
+}
+
+// Robots of one run: poses or IR edges, and the metrics each DriveMonitor writes.
+struct fleet_run {
+  vector<robot_fleet> poses;                      // light: one robot each
+  vector<shared_ptr<pin_edge_queue>> edges;       // line: left, center, right IR of each robot
+  vector<drive_metrics> metrics;
+};
+
+static void add_monitor(fleet_parts& parts, size_t i, const string& controller, drive_metrics* metrics) {
+  const string monitor = fleet_name("monitor", i);
+  parts.models.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<DriveMonitor, TIME>(monitor, metrics));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<controller_defs::rightMotor1, driveMonitor_defs::rightMotor1>(controller, monitor));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<controller_defs::rightMotor2, driveMonitor_defs::rightMotor2>(controller, monitor));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<controller_defs::leftMotor1, driveMonitor_defs::leftMotor1>(controller, monitor));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<controller_defs::leftMotor2, driveMonitor_defs::leftMotor2>(controller, monitor));
+}
+
+static void add_light_robot(fleet_run& run, fleet_parts& parts, size_t i) {
+  const string lightBot = fleet_name("lightBot", i);
+  const string robot = fleet_name("robot", i);
+  parts.models.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<LightBot, TIME>(lightBot));
+  parts.models.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<RobotPlant, TIME>(robot, &run.poses[i], STEP_US));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<robotPlant_defs::lightPair, lightBot_defs::lightPair>(robot, lightBot));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<robotPlant_defs::centerIR, lightBot_defs::centerIR>(robot, lightBot));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor1, robotPlant_defs::rightMotor1>(lightBot, robot));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor2, robotPlant_defs::rightMotor2>(lightBot, robot));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor1, robotPlant_defs::leftMotor1>(lightBot, robot));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor2, robotPlant_defs::leftMotor2>(lightBot, robot));
+  add_monitor(parts, i, lightBot, &run.metrics[i]);
+}
+
+static void add_line_robot(fleet_run& run, fleet_parts& parts, size_t i) {
+  const string driver = fleet_name("seeedBotDriver", i);
+  const string leftIR = fleet_name("leftIR", i);
+  const string centerIR = fleet_name("centerIR", i);
+  const string rightIR = fleet_name("rightIR", i);
+  parts.models.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<SeeedBotDriver, TIME>(driver));
+  parts.models.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<InterruptDigitalInput, TIME>(leftIR, run.edges[3 * i]));
+  parts.models.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<InterruptDigitalInput, TIME>(centerIR, run.edges[3 * i + 1]));
+  parts.models.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<InterruptDigitalInput, TIME>(rightIR, run.edges[3 * i + 2]));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<digitalInput_defs::out, seeedBotDriver_defs::leftIR>(leftIR, driver));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<digitalInput_defs::out, seeedBotDriver_defs::centerIR>(centerIR, driver));
+  parts.ics.push_back(cadmium::dynamic::translate::make_IC<digitalInput_defs::out, seeedBotDriver_defs::rightIR>(rightIR, driver));
+  add_monitor(parts, i, driver, &run.metrics[i]);
+}
+
+// Same robots for every run of a size: same poses, same IR edges.
+static void prepare(fleet_run& run, const string& controller, size_t n, long long until_us, long long period_us) {
+  run.metrics.assign(n, drive_metrics());
+  run.poses.clear();
+  run.edges.clear();
+  if(controller == "light") {
+    robot_fleet scattered(n);
+    scattered.scatter(1);
+    run.poses.assign(n, robot_fleet(1));
+    for(size_t i = 0; i < n; i++) {
+      run.poses[i].set_pose(0, scattered.x[i], scattered.y[i], scattered.heading[i]);
+    }
+  } else {
+    mt19937_64 rng(1);
+    exponential_distribution<double> gap(1.0 / period_us);
+    for(size_t i = 0; i < 3 * n; i++) {
+      auto queue = make_shared<pin_edge_queue>();
+      bool level = false;
+      for(long long t = (long long) gap(rng); t < until_us; t += 1 + (long long) gap(rng)) {
+        level = !level;
+        queue->push(t, level);
+      }
+      run.edges.push_back(queue);
+    }
+  }
+}
+
+static bool same_metrics(const vector<drive_metrics>& a, const vector<drive_metrics>& b) {
+  for(size_t i = 0; i < a.size(); i++) {
+    if(a[i].changes != b[i].changes || a[i].commands != b[i].commands) return false;
+    for(int d = 0; d < 4; d++) {
+      if(a[i].time_us[d] != b[i].time_us[d]) return false;
+    }
+  }
+  return true;
+}
+
+static vector<size_t> parse_sizes(const string& list) {
+  vector<size_t> sizes;
+  stringstream ss(list);
+  string item;
+  while(getline(ss, item, ',')) {
+    if(!item.empty()) sizes.push_back(strtoul(item.c_str(), nullptr, 10));
+  }
+  return sizes;
+}
+
+static void usage() {
+  cerr << "usage: SEEED_BOT_FLEET [-c light|line] [-n 1,10,100,1000,10000] [-j threads] [-u 00:00:10:000] [-p 200]" << endl;
+  exit(2);
+}
+
+int main(int argc, char ** argv) {
+  string controller = "light";
+  vector<size_t> sizes = {1, 10, 100, 1000, 10000};
+  unsigned threads = max(1u, thread::hardware_concurrency());
+  string until_text = "00:00:10:000";
+  long long period_us = 200000;
+  for(int i = 1; i < argc; i++) {
+    const string arg = argv[i];
+    if(i + 1 >= argc) usage();
+    if(arg == "-c") controller = argv[++i];
+    else if(arg == "-n") sizes = parse_sizes(argv[++i]);
+    else if(arg == "-j") threads = max(1, atoi(argv[++i]));
+    else if(arg == "-u") until_text = argv[++i];
+    else if(arg == "-p") period_us = 1000LL * atoi(argv[++i]);
+    else usage();
+  }
+  if(sizes.empty() || period_us <= 0 || (controller != "light" && controller != "line")) usage();
+
+  const TIME until(until_text);
+  const long long until_us = to_microseconds(until);
+  const double simulated_s = until_us / 1e6;
+  vector<unsigned> partitions = {1};
+  if(threads > 1) partitions.push_back(threads);
+
+  bool differ = false;
+  printf("%-6s %8s %8s %10s %10s %14s %16s\n", "ctrl", "robots", "runners", "build s", "run s", "robot-s/s", "us/robot/step");
+  for(size_t n : sizes) {
+    vector<drive_metrics> reference;
+    for(unsigned p : partitions) {
+      fleet_run run;
+      prepare(run, controller, n, until_us, period_us);
+      auto start = hclock::now();
+      fleet_runner<TIME> fleet(n, p, [&](fleet_parts& parts, size_t i) {
+        if(controller == "light") add_light_robot(run, parts, i);
+        else add_line_robot(run, parts, i);
+      });
+      const double build_s = seconds_since(start);
+      start = hclock::now();
+      fleet.run_until(until);
+      const double run_s = seconds_since(start);
+      for(drive_metrics& m : run.metrics) m.finish(until_us);
+
+      const double steps = n * (until_us / (double) STEP_US);
+      printf("%-6s %8zu %8zu %10.3f %10.3f %14.1f %16.3f", controller.c_str(), n, fleet.partitions(), build_s, run_s,
+             run_s > 0 ? n * simulated_s / run_s : 0.0, steps > 0 ? run_s * 1e6 / steps : 0.0);
+      if(reference.empty()) {
+        reference = run.metrics;
+        printf("\n");
+      } else {
+        const bool same = same_metrics(reference, run.metrics);
+        differ = differ || !same;
+        printf("  %s\n", same ? "same metrics" : "METRICS DIFFER");
+      }
+    }
+  }
+  return differ ? 1 : 0;
+}
@@ -0,0 +1,244 @@
+/**
+* ARSLab - Carleton University
+*
+* Interrupt Report:
+* Compares the edge-latching center IR input (atomics/interruptDigitalInput.hpp) with polling
+* it, on the same pin edges and at the same periods. The interrupt model is run the way it
+* works on target: the latch is checked once per period (the watchdog), so its stop latency is
+* bounded by the period like polling. For every loss of ground it measures the time until
+* LightBot commands stop, counts the losses LightBot never stopped for, and counts how often
+* the input model wakes up.
+*
+*   ./IRQ_REPORT [scenario dir] [-p 10,50,100,1000] [-n pulses] [-u 00:10:00:000]
+*
+* The edges come from A2_CenterIR_In.txt of the scenario (./inputs by default), or with -n
+* from that many random ground losses of 5 to 500 ms. -p lists the periods in ms.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cadmium/modeling/coupling.hpp>
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/concept/coupled_model_assert.hpp>
+#include <cadmium/modeling/dynamic_coupled.hpp>
+#include <cadmium/modeling/dynamic_atomic.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#include <NDTime.hpp>
+
+#include <cadmium/real_time/arm_mbed/io/digitalInput.hpp>
+#include <cadmium/real_time/arm_mbed/io/analogInput.hpp>
+
+#include "../atomics/lightBot.hpp"
+#include "../atomics/driveMonitor.hpp"
+#include "../atomics/interruptDigitalInput.hpp"
+#include "../utilities/time_conversion.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+struct variant {
+  long long period_us; // poll or latch check period
+  bool interrupt;
+  digital_input_stats stats;
+  drive_metrics metrics;
+  vector<drive_change> history;
+  double seconds;
+};
+
+static shared_ptr<pin_edge_queue> make_queue(const vector<pin_edge_queue::edge>& edges) {
+  auto queue = make_shared<pin_edge_queue>();
+  queue->push(0, true);
+  for(const auto& e : edges) queue->push(e.time_us, e.level);
+  return queue;
+}
+
+static void run_variant(variant& run, const string& dir, const vector<pin_edge_queue::edge>& edges, const TIME& until) {
+  const string A4 = dir + "/A4_leftLightSens_In.txt";
+  const string A5 = dir + "/A5_rightLightSens_In.txt";
+
+  using AtomicModelPtr=std::shared_ptr<cadmium::dynamic::modeling::model>;
+  using CoupledModelPtr=std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>>;
+
+  run.metrics.history = &run.history;
+
+  AtomicModelPtr centerIR;
+  if(run.interrupt) {
+    centerIR = cadmium::dynamic::translate::make_dynamic_atomic_model<InterruptDigitalInput, TIME>("centerIR", make_queue(edges), &run.stats, run.period_us);
+  } else {
+    centerIR = cadmium::dynamic::translate::make_dynamic_atomic_model<PolledDigitalInput, TIME>("centerIR", make_queue(edges), run.period_us, &run.stats);
+  }
+  AtomicModelPtr lightBot = cadmium::dynamic::translate::make_dynamic_atomic_model<LightBot, TIME>("lightBot");
+  AtomicModelPtr rightLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<AnalogInput, TIME>("rightLightSens", A5.c_str());
+  AtomicModelPtr leftLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<AnalogInput, TIME>("leftLightSens", A4.c_str());
+  AtomicModelPtr monitor = cadmium::dynamic::translate::make_dynamic_atomic_model<DriveMonitor, TIME>("monitor", &run.metrics);
+
+  cadmium::dynamic::modeling::Ports iports_TOP = {};
+  cadmium::dynamic::modeling::Ports oports_TOP = {};
+  cadmium::dynamic::modeling::Models submodels_TOP = {rightLightSens, leftLightSens, lightBot, centerIR, monitor};
+  cadmium::dynamic::modeling::EICs eics_TOP = {};
+  cadmium::dynamic::modeling::EOCs eocs_TOP = {};
+  cadmium::dynamic::modeling::ICs ics_TOP = {
+     cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor1, driveMonitor_defs::rightMotor1>("lightBot","monitor"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor2, driveMonitor_defs::rightMotor2>("lightBot","monitor"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor1, driveMonitor_defs::leftMotor1>("lightBot","monitor"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor2, driveMonitor_defs::leftMotor2>("lightBot","monitor"),
+
+     cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::rightLightSens>("rightLightSens", "lightBot"),
+     cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::leftLightSens>("leftLightSens", "lightBot"),
+
+     cadmium::dynamic::translate::make_IC<digitalInput_defs::out, lightBot_defs::centerIR>("centerIR", "lightBot")
+  };
+  CoupledModelPtr TOP = std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
+   "TOP",
+   submodels_TOP,
+   iports_TOP,
+   oports_TOP,
+   eics_TOP,
+   eocs_TOP,
+   ics_TOP
+   );
+
+  auto start = hclock::now();
+  cadmium::dynamic::engine::runner<TIME, cadmium::logger::not_logger> r(TOP, {0});
+  r.run_until(until);
+  run.metrics.finish(to_microseconds(until));
+  run.seconds = chrono::duration_cast<chrono::duration<double>>(hclock::now() - start).count();
+}
+
+struct stop_latency {
+  long long worst_us;
+  double mean_us;
+  unsigned long stops;  // ground losses LightBot stopped for
+  unsigned long missed; // ground losses LightBot did not stop for before the next one
+};
+
+// For every loss of ground (pin falling to 0) the time until the drive direction is stop, if
+// that happens before the next loss. The stop may come after the ground is back: a latched
+// loss is reported at the next check.
+static stop_latency measure(const vector<pin_edge_queue::edge>& edges, const vector<drive_change>& history, long long end_us) {
+  stop_latency l = {0, 0, 0, 0};
+  double total = 0;
+  for(size_t i = 0; i < edges.size(); i++) {
+    if(edges[i].level) continue;
+    const long long lost = edges[i].time_us;
+    long long next_loss = end_us;
+    for(size_t j = i + 1; j < edges.size(); j++) {
+      if(!edges[j].level) {
+        next_loss = edges[j].time_us;
+        break;
+      }
+    }
+    if(lost >= end_us) break;
+    DriveState dir = DriveState::stop;
+    size_t h = 0;
+    for(; h < history.size() && history[h].time_us <= lost; h++) dir = history[h].dir;
+    long long stopped = -1;
+    if(dir == DriveState::stop) {
+      stopped = lost;
+    } else {
+      for(; h < history.size() && history[h].time_us < next_loss; h++) {
+        if(history[h].dir == DriveState::stop) {
+          stopped = history[h].time_us;
+          break;
+        }
+      }
+    }
+    if(stopped < 0) {
+      l.missed++;
+      continue;
+    }
+    l.stops++;
+    total += stopped - lost;
+    l.worst_us = max(l.worst_us, stopped - lost);
+  }
+  l.mean_us = l.stops ? total / l.stops : 0;
+  return l;
+}
+
+static vector<pin_edge_queue::edge> load_edges(const string& path) {
+  pin_edge_queue queue(path.c_str());
+  vector<pin_edge_queue::edge> edges;
+  if(!queue.initial_level()) edges.push_back({0, false});
+  for(; !queue.empty(); queue.pop()) edges.push_back(queue.front());
+  return edges;
+}
+
+// pulses ground losses of 5 to 500 ms, at random times over [0, end_us).
+static vector<pin_edge_queue::edge> random_edges(int pulses, long long end_us) {
+  mt19937_64 rng(1);
+  const long long slot = end_us / max(pulses, 1);
+  vector<pin_edge_queue::edge> edges;
+  for(int i = 0; i < pulses; i++) {
+    const long long length = 5000 + (long long) (rng() % 495001);
+    const long long start = i * slot + (long long) (rng() % (unsigned long long) max(slot - length, 1LL));
+    edges.push_back({start, false});
+    edges.push_back({start + length, true});
+  }
+  return edges;
+}
+
+static void usage() {
+  cerr << "usage: IRQ_REPORT [scenario dir] [-p 10,50,100,1000] [-n pulses] [-u 00:10:00:000]" << endl;
+  exit(2);
+}
+
+int main(int argc, char ** argv) {
+  string dir = "./inputs";
+  string periods_text = "10,50,100,1000";
+  string until_text = "00:10:00:000";
+  int pulses = 0;
+  int i = 1;
+  if(i < argc && argv[i][0] != '-') dir = argv[i++];
+  for(; i < argc; i++) {
+    const string arg = argv[i];
+    if(i + 1 >= argc) usage();
+    if(arg == "-p") periods_text = argv[++i];
+    else if(arg == "-n") pulses = atoi(argv[++i]);
+    else if(arg == "-u") until_text = argv[++i];
+    else usage();
+  }
+
+  const TIME until(until_text);
+  const long long end_us = to_microseconds(until);
+  const vector<pin_edge_queue::edge> edges = pulses > 0 ? random_edges(pulses, end_us) : load_edges(dir + "/A2_CenterIR_In.txt");
+
+  vector<variant> runs;
+  for(size_t p = 0; p < periods_text.size();) {
+    const size_t comma = min(periods_text.find(',', p), periods_text.size());
+    const long long period_us = atoll(periods_text.substr(p, comma - p).c_str()) * 1000;
+    for(bool interrupt : {false, true}) {
+      runs.emplace_back();
+      runs.back().period_us = period_us;
+      runs.back().interrupt = interrupt;
+    }
+    p = comma + 1;
+  }
+
+  const double seconds = end_us / 1e6;
+  printf("%zu pin edges over %s\n\n", edges.size(), until_text.c_str());
+  printf("%-16s %12s %12s %8s %8s %12s %12s %10s\n", "center IR", "worst stop", "mean stop", "stops", "missed", "wakeups", "wakeups/s", "wall (s)");
+  for(auto& run : runs) {
+    run_variant(run, dir, edges, until);
+    const stop_latency l = measure(edges, run.history, end_us);
+    char name[32];
+    snprintf(name, sizeof(name), "%s %lld ms", run.interrupt ? "latch" : "poll", run.period_us / 1000);
+    printf("%-16s %9.3f ms %9.3f ms %8lu %8lu %12lu %12.2f %10.3f\n", name, l.worst_us / 1000.0, l.mean_us / 1000.0,
+           l.stops, l.missed, run.stats.wakeups, run.stats.wakeups / seconds, run.seconds);
+  }
+  printf("\nThe real-time clock is not woken by the interrupt: a latched edge reaches LightBot at the next\n"
+         "check, every INTERRUPT_INPUT_WATCHDOG_MS (%d ms) on target.\n", INTERRUPT_INPUT_WATCHDOG_MS);
+  return 0;
+}
@@ -5,7 +5,11 @@
 * Analog Input:
 * This main file constructs the do simple line following project, using a Seed Bot Shield.
 * Its purpose is to demonstrate how to use all of the port IO models in RT_ARM_MBED.
+*
+* This is the dynamic top model. main_static.cpp builds the same system as a static
+* (compile-time) coupled model and is used instead when STATIC_TOP_MODEL is defined.
 */
+#ifndef STATIC_TOP_MODEL
 
 #include <iostream>
 #include <chrono>
@@ -24,7 +28,11 @@
 #include <cadmium/io/iestream.hpp>
 
 
-#include <NDTime.hpp>
+#ifdef TICK_TIME
+  #include "../utilities/tick_time.hpp"
+#else
+  #include <NDTime.hpp>
+#endif
 
 #include <cadmium/real_time/arm_mbed/io/digitalInput.hpp>
 #include <cadmium/real_time/arm_mbed/io/analogInput.hpp>
@@ -32,56 +40,176 @@
 #include <cadmium/real_time/arm_mbed/io/digitalOutput.hpp>
 
 #include "../atomics/lightBot.hpp"
+#include "../atomics/steeringBot.hpp"
+#include "../atomics/lineLightBot.hpp"
+#include "../atomics/latencyProbe.hpp"
+#include "../atomics/modelProfiler.hpp"
+#include "../atomics/filteredInput.hpp"
+#include "../atomics/interruptDigitalInput.hpp"
+#include "../atomics/dualAnalogInput.hpp"
+#include "../atomics/telemetryTap.hpp"
+#include "../atomics/deadlineMonitor.hpp"
+#include "../utilities/ring_logger.hpp"
 
 #ifdef RT_ARM_MBED
   #include "../mbed.h"
+  // printf and cout go through the log ring buffer, so the log drain is the only writer
+  // of the stdio serial port.
+  namespace mbed {
+    FileHandle* mbed_override_console(int) {
+      static RingConsole console;
+      return &console;
+    }
+  }
+#elif defined(BINARY_TRACES)
+  // Replay the binary traces made with TRACE_CONVERT ("make binary_traces")
+  #include "../atomics/binaryTraceInput.hpp"
+  const char* A2  = "./inputs/A2_CenterIR_In.sbt";
+  const char* A4  = "./inputs/A4_leftLightSens_In.sbt";
+  const char* A5  = "./inputs/A5_rightLightSens_In.sbt";
+  #ifdef LINE_LIGHT_BOT
+    const char* A1  = "./inputs/A1_LeftIR_In.sbt";
+    const char* A3  = "./inputs/A3_RightIR_In.sbt";
+    const char* D2  = "./inputs/D2_Mode_In.sbt";
+  #endif
 #else
   const char* A2  = "./inputs/A2_CenterIR_In.txt";
   const char* A4  = "./inputs/A4_leftLightSens_In.txt";
   const char* A5  = "./inputs/A5_rightLightSens_In.txt";
+  #ifdef LINE_LIGHT_BOT
+    const char* A1  = "./inputs/A1_LeftIR_In.txt";
+    const char* A3  = "./inputs/A3_RightIR_In.txt";
+    const char* D2  = "./inputs/D2_Mode_In.txt";
+  #endif
+#endif
+
+#if !defined(RT_ARM_MBED) && defined(LINE_LIGHT_BOT)
+  // Not over the LightBot reference outputs (replay.cpp), "make line_light" creates the directory.
+  const char* D8  = "./outputs/line_light/D8_RightMotor1_Out.txt";
+  const char* D11 = "./outputs/line_light/D11_RightMotor2_Out.txt";
+  const char* D12 = "./outputs/line_light/D12_LeftMotor1_Out.txt";
+  const char* D13 = "./outputs/line_light/D13_LeftMotor2_Out.txt";
+#elif !defined(RT_ARM_MBED)
   const char* D8  = "./outputs/D8_RightMotor1_Out.txt";
   const char* D11 = "./outputs/D11_RightMotor2_Out.txt";
   const char* D12 = "./outputs/D12_LeftMotor1_Out.txt";
   const char* D13 = "./outputs/D13_LeftMotor2_Out.txt";
 #endif
 
+#if !defined(RT_ARM_MBED) && defined(BINARY_TRACES)
+  template<typename T> using DigitalInputModel = BinaryDigitalInput<T>;
+  template<typename T> using AnalogInputModel = BinaryAnalogInput<T>;
+#else
+  template<typename T> using DigitalInputModel = DigitalInput<T>;
+  template<typename T> using AnalogInputModel = AnalogInput<T>;
+#endif
+// Every model is checked against the wall clock when built with -DDEADLINE_MONITOR (atomics/deadlineMonitor.hpp).
+// The monitor sits under the filter, so a coalesced sample is not taken as sent by it.
+template<typename T> using FilteredAnalogInput = filtered_input<deadline_monitor<AnalogInputModel>::model>::model<T>;
+
+// Both light sensors are read in one ADC scan and sent to LightBot as a light_pair
+// (atomics/dualAnalogInput.hpp). Build with -DSEPARATE_LIGHT_INPUTS for one AnalogInput per sensor.
+#if !defined(SEPARATE_LIGHT_INPUTS) && (defined(RT_ARM_MBED) || !defined(BINARY_TRACES))
+  #define PAIRED_LIGHT_INPUTS
+  template<typename T> using FilteredDualAnalogInput = filtered_input<deadline_monitor<DualAnalogInput>::model>::model<T>;
+#endif
+
+// LightBot bang-bangs between left, straight and right. Build with -DPROPORTIONAL_STEERING to
+// steer with the PWM ports instead (atomics/steeringBot.hpp); the ports are the same.
+// Build with -DLINE_LIGHT_BOT for line following and light seeking in one controller
+// (atomics/lineLightBot.hpp): the left (A1) and right (A3) IRs are added, and the mode pin (D2)
+// selects line following when high. It keeps the lightBot id and motor couplings.
+#if defined(LINE_LIGHT_BOT) && defined(SCARED_OF_THE_DARK)
+  #error "LINE_LIGHT_BOT does not wire the lightSensor port of SCARED_OF_THE_DARK"
+#endif
+#if defined(LINE_LIGHT_BOT)
+  template<typename T> using LightController = LineLightBot<T>;
+#elif defined(PROPORTIONAL_STEERING)
+  template<typename T> using LightController = SteeringBot<T>;
+#else
+  template<typename T> using LightController = LightBot<T>;
+#endif
+
+// The center IR pin is polled every 100 ms like the other inputs. Build with -DINTERRUPT_CENTER_IR
+// to also latch its edges in an interrupt (atomics/interruptDigitalInput.hpp): still polled, same
+// latency, but a ground loss shorter than the poll period is not missed. Not with the binary traces.
+#if defined(INTERRUPT_CENTER_IR) && !defined(RT_ARM_MBED) && defined(BINARY_TRACES)
+  #undef INTERRUPT_CENTER_IR
+#endif
+#ifdef INTERRUPT_CENTER_IR
+  template<typename T> using CenterIRModel = InterruptDigitalInput<T>;
+#else
+  template<typename T> using CenterIRModel = DigitalInputModel<T>;
+#endif
+
+// Pin changes are written to the telemetry stream when built with -DTELEMETRY (atomics/telemetryTap.hpp).
+template<typename T> using TappedCenterIR = telemetry_source<deadline_monitor<CenterIRModel>::model>::model<T>;
+template<typename T> using TappedLightInput = telemetry_source<FilteredAnalogInput>::model<T>;
+#ifdef PAIRED_LIGHT_INPUTS
+  template<typename T> using TappedLightPair = telemetry_source<FilteredDualAnalogInput>::model<T>;
+#endif
+template<typename T> using TappedPwmOutput = telemetry_sink<deadline_monitor<PwmOutput>::model>::model<T>;
+template<typename T> using TappedDigitalOutput = telemetry_sink<deadline_monitor<DigitalOutput>::model>::model<T>;
+#ifdef LINE_LIGHT_BOT
+  // The telemetry has no codes for the line IR and mode pins.
+  template<typename T> using LineLightInput = deadline_monitor<DigitalInputModel>::model<T>;
+#endif
+
+#ifdef RT_ARM_MBED
+  // Motor driver enables.
+  DigitalOut rightMotorEn(D9);
+  DigitalOut leftMotorEn(D10);
+#endif
+
 using namespace std;
 
 using hclock=chrono::high_resolution_clock;
-using TIME = NDTime;
+// Build with -DTICK_TIME for integer microsecond time (utilities/tick_time.hpp)
+#ifdef TICK_TIME
+  using TIME = TickTime;
+#else
+  using TIME = NDTime;
+#endif
 
 int main(int argc, char ** argv) {
 
   //This will end the main thread and create a new one with more stack.
+  /*************** Loggers *******************/
+  // Log text goes into a ring buffer and is written out by a low-priority thread,
+  // so writing the log never blocks the control loop. Lines that do not fit are counted as
+  // overflows. The Cadmium formatters still build the text in the transitions (see
+  // utilities/ring_logger.hpp); build with -DNO_LOGS to leave it out.
   #ifdef RT_ARM_MBED
-    //Logging is done over cout in RT_ARM_MBED
-    struct oss_sink_provider{
-      static std::ostream& sink(){
-        return cout;
-      }
-    };
+    //Logging is done over the stdio serial port in RT_ARM_MBED
+    RingLogDrain log_drain(ring_log_buffer(), USBTX, USBRX);
   #else
     // all simulation timing and I/O streams are ommited when running real_time/arm_mbed
 
     auto start = hclock::now(); //to measure simulation execution time
 
-    /*************** Loggers *******************/
-
     static std::ofstream out_data("seeed_bot_test_output.txt");
-    struct oss_sink_provider{
-      static std::ostream& sink(){
-        return out_data;
-      }
-    };
+    RingLogDrain log_drain(ring_log_buffer(), out_data);
+  #endif
+  log_drain.start();
+
+  #ifdef TELEMETRY
+    // Telemetry frames share the log ring buffer (and the serial port in RT_ARM_MBED);
+    // TELEMETRY_DECODE skips any text between them.
+    #ifdef RT_ARM_MBED
+      telemetry_stream().open(&ring_sink_provider::sink());
+    #else
+      static std::ofstream telemetry_data("telemetry.bin", std::ios::binary);
+      telemetry_stream().open(&telemetry_data);
+    #endif
   #endif
 
-  using info=cadmium::logger::logger<cadmium::logger::logger_info, cadmium::dynamic::logger::formatter<TIME>, oss_sink_provider>;
-  using debug=cadmium::logger::logger<cadmium::logger::logger_debug, cadmium::dynamic::logger::formatter<TIME>, oss_sink_provider>;
-  using state=cadmium::logger::logger<cadmium::logger::logger_state, cadmium::dynamic::logger::formatter<TIME>, oss_sink_provider>;
-  using log_messages=cadmium::logger::logger<cadmium::logger::logger_messages, cadmium::dynamic::logger::formatter<TIME>, oss_sink_provider>;
-  using routing=cadmium::logger::logger<cadmium::logger::logger_message_routing, cadmium::dynamic::logger::formatter<TIME>, oss_sink_provider>;
-  using global_time=cadmium::logger::logger<cadmium::logger::logger_global_time, cadmium::dynamic::logger::formatter<TIME>, oss_sink_provider>;
-  using local_time=cadmium::logger::logger<cadmium::logger::logger_local_time, cadmium::dynamic::logger::formatter<TIME>, oss_sink_provider>;
+  using info=cadmium::logger::logger<cadmium::logger::logger_info, cadmium::dynamic::logger::formatter<TIME>, ring_sink_provider>;
+  using debug=cadmium::logger::logger<cadmium::logger::logger_debug, cadmium::dynamic::logger::formatter<TIME>, ring_sink_provider>;
+  using state=cadmium::logger::logger<cadmium::logger::logger_state, cadmium::dynamic::logger::formatter<TIME>, ring_sink_provider>;
+  using log_messages=cadmium::logger::logger<cadmium::logger::logger_messages, cadmium::dynamic::logger::formatter<TIME>, ring_sink_provider>;
+  using routing=cadmium::logger::logger<cadmium::logger::logger_message_routing, cadmium::dynamic::logger::formatter<TIME>, ring_sink_provider>;
+  using global_time=cadmium::logger::logger<cadmium::logger::logger_global_time, cadmium::dynamic::logger::formatter<TIME>, ring_sink_provider>;
+  using local_time=cadmium::logger::logger<cadmium::logger::logger_local_time, cadmium::dynamic::logger::formatter<TIME>, ring_sink_provider>;
   using log_all=cadmium::logger::multilogger<info, debug, state, log_messages, routing, global_time, local_time>;
   using logger_top=cadmium::logger::multilogger<log_messages, global_time>;
 
@@ -99,25 +227,80 @@ int main(int argc, char ** argv) {
 /********** LightBot ************************/
 /********************************************/
 
-  AtomicModelPtr lightBot = cadmium::dynamic::translate::make_dynamic_atomic_model<LightBot, TIME>("lightBot");
+  // The latency_* decorators only measure when built with LATENCY_PROBES (see atomics/latencyProbe.hpp),
+  // profiled only when built with MODEL_PROFILER (see atomics/modelProfiler.hpp).
+  // Each model gets one instrumentation {name, deadline, input filter, telemetry pin} for all its
+  // decorators (utilities/instrumentation.hpp), passed ahead of the model's own arguments.
+  // Deadline budgets {budget_us, coalesce}: stale light samples are dropped, edges and motor commands never.
+  const deadline_policy sensorDeadline = {1000, true};
+  const deadline_policy controlDeadline = {1000, false};
+
+  const instrumentation lightBotConfig = {"lightBot", controlDeadline};
+  AtomicModelPtr lightBot = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_relay<deadline_monitor<LightController>::model>::model>::model, TIME>(lightBotConfig.name, lightBotConfig);
 
 /********************************************/
 /****************** Input *******************/
 /********************************************/
 
-  AtomicModelPtr centerIR = cadmium::dynamic::translate::make_dynamic_atomic_model<DigitalInput, TIME>("centerIR", A2);
+  const instrumentation centerIRConfig = {"centerIR", controlDeadline, no_input_filter, telemetry_pin::A2};
+  #if defined(INTERRUPT_CENTER_IR) && defined(RT_ARM_MBED)
+    digital_input_stats centerIRStats;
+    AtomicModelPtr centerIR = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_source<TappedCenterIR>::model>::model, TIME>(centerIRConfig.name, centerIRConfig, A2, &centerIRStats);
+  #elif defined(INTERRUPT_CENTER_IR)
+    // The latch is checked at the watchdog period, as on target.
+    digital_input_stats centerIRStats;
+    AtomicModelPtr centerIR = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_source<TappedCenterIR>::model>::model, TIME>(centerIRConfig.name, centerIRConfig, A2, &centerIRStats, INTERRUPT_INPUT_WATCHDOG_MS * 1000LL);
+  #else
+    AtomicModelPtr centerIR = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_source<TappedCenterIR>::model>::model, TIME>(centerIRConfig.name, centerIRConfig, A2);
+  #endif
+
+  #ifdef LINE_LIGHT_BOT
+    const instrumentation leftIRConfig = {"leftIR", controlDeadline};
+    const instrumentation rightIRConfig = {"rightIR", controlDeadline};
+    const instrumentation modeConfig = {"mode", controlDeadline};
+    AtomicModelPtr leftIR = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<LineLightInput>::model, TIME>(leftIRConfig.name, leftIRConfig, A1);
+    AtomicModelPtr rightIR = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<LineLightInput>::model, TIME>(rightIRConfig.name, rightIRConfig, A3);
+    AtomicModelPtr mode = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<LineLightInput>::model, TIME>(modeConfig.name, modeConfig, D2);
+  #endif
   
-  AtomicModelPtr rightLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<AnalogInput, TIME>("rightLightSens", A5);
-  AtomicModelPtr leftLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<AnalogInput, TIME>("leftLightSens", A4);
+  // Light sensor filtering (atomics/filteredInput.hpp): {deadband, decimation, minimum period in us}.
+  // Off by default: a deadband can change LightBot's decisions, check a setting with FILTER_REPORT first.
+  #ifdef PAIRED_LIGHT_INPUTS
+    input_filter lightPairFilter = no_input_filter;
+    #ifndef RT_ARM_MBED
+      // Optional override, a "lightPair deadband decimation period_us" line
+      load_input_filters("input_filters.txt", "lightPair", lightPairFilter);
+    #endif
+
+    const instrumentation lightPairConfig = {"lightPair", sensorDeadline, lightPairFilter, telemetry_pin::A4};
+    AtomicModelPtr lightPair = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_source<TappedLightPair>::model>::model, TIME>(lightPairConfig.name, lightPairConfig, A4, A5);
+  #else
+    input_filter rightLightFilter = no_input_filter;
+    input_filter leftLightFilter = no_input_filter;
+    #ifndef RT_ARM_MBED
+      // Optional overrides, one "name deadband decimation period_us" line per pin
+      load_input_filters("input_filters.txt", "rightLightSens", rightLightFilter);
+      load_input_filters("input_filters.txt", "leftLightSens", leftLightFilter);
+    #endif
+
+    const instrumentation rightLightConfig = {"rightLightSens", sensorDeadline, rightLightFilter, telemetry_pin::A5};
+    const instrumentation leftLightConfig = {"leftLightSens", sensorDeadline, leftLightFilter, telemetry_pin::A4};
+    AtomicModelPtr rightLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_source<TappedLightInput>::model>::model, TIME>(rightLightConfig.name, rightLightConfig, A5);
+    AtomicModelPtr leftLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_source<TappedLightInput>::model>::model, TIME>(leftLightConfig.name, leftLightConfig, A4);
+  #endif
  
 /********************************************/
 /***************** Output *******************/
 /********************************************/
 
-  AtomicModelPtr rightMotor1 = cadmium::dynamic::translate::make_dynamic_atomic_model<PwmOutput, TIME>("rightMotor1", D11);
-  AtomicModelPtr rightMotor2 = cadmium::dynamic::translate::make_dynamic_atomic_model<DigitalOutput, TIME>("rightMotor2", D8);
-  AtomicModelPtr leftMotor1 = cadmium::dynamic::translate::make_dynamic_atomic_model<PwmOutput, TIME>("leftMotor1", D13);
-  AtomicModelPtr leftMotor2 = cadmium::dynamic::translate::make_dynamic_atomic_model<DigitalOutput, TIME>("leftMotor2", D12);
+  const instrumentation rightMotor1Config = {"rightMotor1", controlDeadline, no_input_filter, telemetry_pin::D11};
+  const instrumentation rightMotor2Config = {"rightMotor2", controlDeadline, no_input_filter, telemetry_pin::D8};
+  const instrumentation leftMotor1Config = {"leftMotor1", controlDeadline, no_input_filter, telemetry_pin::D13};
+  const instrumentation leftMotor2Config = {"leftMotor2", controlDeadline, no_input_filter, telemetry_pin::D12};
+  AtomicModelPtr rightMotor1 = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_sink<TappedPwmOutput>::model>::model, TIME>(rightMotor1Config.name, rightMotor1Config, D11);
+  AtomicModelPtr rightMotor2 = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_sink<TappedDigitalOutput>::model>::model, TIME>(rightMotor2Config.name, rightMotor2Config, D8);
+  AtomicModelPtr leftMotor1 = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_sink<TappedPwmOutput>::model>::model, TIME>(leftMotor1Config.name, leftMotor1Config, D13);
+  AtomicModelPtr leftMotor2 = cadmium::dynamic::translate::make_dynamic_atomic_model<profiled<latency_sink<TappedDigitalOutput>::model>::model, TIME>(leftMotor2Config.name, leftMotor2Config, D12);
 
 
 /************************/
@@ -126,7 +309,19 @@ int main(int argc, char ** argv) {
   cadmium::dynamic::modeling::Ports iports_TOP = {};
   cadmium::dynamic::modeling::Ports oports_TOP = {};
 
-  cadmium::dynamic::modeling::Models submodels_TOP =  {rightLightSens, leftLightSens, lightBot, centerIR, rightMotor1, rightMotor2, leftMotor1, leftMotor2};
+  #ifdef PAIRED_LIGHT_INPUTS
+    cadmium::dynamic::modeling::Models submodels_TOP =  {lightPair, lightBot, centerIR, rightMotor1, rightMotor2, leftMotor1, leftMotor2};
+  #else
+    cadmium::dynamic::modeling::Models submodels_TOP =  {rightLightSens, leftLightSens, lightBot, centerIR, rightMotor1, rightMotor2, leftMotor1, leftMotor2};
+  #endif
+  #ifdef LINE_LIGHT_BOT
+    submodels_TOP.insert(submodels_TOP.end(), {leftIR, rightIR, mode});
+  #endif
+
+  #ifdef MODEL_PROFILER
+    // Transition counts and time of every model, every 10 s through the log ring buffer.
+    submodels_TOP.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<ProfileReporter, TIME>("profiler", 10000000LL, &ring_sink_provider::sink()));
+  #endif
 
   cadmium::dynamic::modeling::EICs eics_TOP = {};
   cadmium::dynamic::modeling::EOCs eocs_TOP = {};
@@ -136,8 +331,20 @@ int main(int argc, char ** argv) {
      cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor1, pwmOutput_defs::in>("lightBot","leftMotor1"),
      cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor2, digitalOutput_defs::in>("lightBot","leftMotor2"),
 
+  #ifdef PAIRED_LIGHT_INPUTS
+     cadmium::dynamic::translate::make_IC<dualAnalogInput_defs::out, lightBot_defs::lightPair>("lightPair", "lightBot"),
+  #else
      cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::rightLightSens>("rightLightSens", "lightBot"),
      cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::leftLightSens>("leftLightSens", "lightBot"),
+  #endif
+
+  #ifdef LINE_LIGHT_BOT
+     // The center IR feeds both policies.
+     cadmium::dynamic::translate::make_IC<digitalInput_defs::out, seeedBotDriver_defs::centerIR>("centerIR", "lightBot"),
+     cadmium::dynamic::translate::make_IC<digitalInput_defs::out, seeedBotDriver_defs::leftIR>("leftIR", "lightBot"),
+     cadmium::dynamic::translate::make_IC<digitalInput_defs::out, seeedBotDriver_defs::rightIR>("rightIR", "lightBot"),
+     cadmium::dynamic::translate::make_IC<digitalInput_defs::out, controller_defs::mode>("mode", "lightBot"),
+  #endif
 
      cadmium::dynamic::translate::make_IC<digitalInput_defs::out, lightBot_defs::centerIR>("centerIR", "lightBot")
   };
@@ -155,22 +362,96 @@ int main(int argc, char ** argv) {
 
   #ifdef RT_ARM_MBED
     //Enable the motors:
-    DigitalOut rightMotorEn(D9);
-    DigitalOut leftMotorEn(D10);
     rightMotorEn = 1;
     leftMotorEn = 1;
   #endif
 
-  // Logs are currently blocking opperations. It is recommended to turn them off when embedding your application.
-  // They can be used for testing; however, keep in mind they will add extra delay to your model.
+  // Logs are buffered and written out off the control loop, they only cost the time to format them.
+  // It is still recommended to turn them off when embedding your application.
 
-  //cadmium::dynamic::engine::runner<NDTime, cadmium::logger::not_logger> r(TOP, {0});
+  //cadmium::dynamic::engine::runner<TIME, cadmium::logger::not_logger> r(TOP, {0});
 
-  cadmium::dynamic::engine::runner<NDTime, log_all> r(TOP, {0});
+  #ifdef TELEMETRY
+    // The text logs would not fit in the serial bandwidth next to the telemetry.
+    cadmium::dynamic::engine::runner<TIME, cadmium::logger::not_logger> r(TOP, {0});
+  #elif defined(NO_LOGS)
+    // Same logger as main_static.cpp, for compare_builds.sh.
+    cadmium::dynamic::engine::runner<TIME, cadmium::logger::not_logger> r(TOP, {0});
+  #else
+    cadmium::dynamic::engine::runner<TIME, log_all> r(TOP, {0});
+  #endif
 
-  r.run_until(NDTime("00:10:00:000"));
+  #ifdef DEADLINE_MONITOR
+    deadline_stats::start();
+  #endif
+  #ifdef LATENCY_PROBES
+    latency_probe::start();
+  #endif
+  #ifndef RT_ARM_MBED
+    auto run_start = hclock::now();
+  #endif
+  r.run_until(TIME({0, 10, 0, 0}));
+  #ifndef RT_ARM_MBED
+    const double run_seconds = chrono::duration_cast<chrono::duration<double>>(hclock::now() - run_start).count();
+  #endif
+
+  #ifdef TELEMETRY
+    telemetry_stream().flush();
+  #endif
+
+  // The reports below must not be lost to a full ring buffer in RT_ARM_MBED, where stdout goes
+  // through it too: wait for the drain from here on.
+  ring_log_buffer().set_wait(true);
+  #ifndef RT_ARM_MBED
+    log_drain.stop();
+  #endif
+  if(ring_log_buffer().overflows() > 0) {
+    cout << "Log lines dropped (ring buffer full): " << ring_log_buffer().overflows() << endl;
+  }
+
+  // Light sensor samples read and sent to LightBot
+  input_filter_stats::report(stdout);
+
+  #ifdef INTERRUPT_CENTER_IR
+    printf("centerIR         wakeups %10lu  edges %10lu  sent %10lu\n", centerIRStats.wakeups, centerIRStats.edges, centerIRStats.sent);
+  #endif
+
+  #if defined(RT_ARM_MBED) && defined(PAIRED_LIGHT_INPUTS)
+    if(light_pair_scanner::timeouts() > 0) {
+      printf("lightPair        scan timeouts %lu (read with AnalogIn)\n", light_pair_scanner::timeouts());
+    }
+  #endif
+
+  #ifdef MODEL_PROFILER
+    model_profile::report(stdout);
+  #endif
+
+  #ifdef DEADLINE_MONITOR
+    deadline_stats::report(stdout);
+  #endif
+
+  #ifdef LATENCY_PROBES
+    // Sensor to motor latency histograms, one per motor output
+    #ifdef RT_ARM_MBED
+      latency_probe::report(stdout);
+    #else
+      FILE* latency_file = fopen("latency_report.txt", "w");
+      if(latency_file) {
+        latency_probe::report(latency_file);
+        fclose(latency_file);
+      }
+    #endif
+  #endif
+
+  #ifdef RT_ARM_MBED
+    fflush(stdout);
+    log_drain.stop();
+  #endif
 
   #ifndef RT_ARM_MBED
+    cout << "Run took: " << run_seconds << " s" << endl;
+    cout << "Simulation took: " << chrono::duration_cast<chrono::duration<double>>(hclock::now() - start).count() << " s" << endl;
     return 0;
   #endif
 }
+#endif // STATIC_TOP_MODEL
@@ -0,0 +1,268 @@
+/**
+* ARSLab - Carleton University
+*
+* Static top model:
+* The LightBot system of main.cpp, assembled as a static (compile-time) Cadmium coupled model.
+* Couplings are resolved by the compiler and messages travel in typed message bags,
+* so there is no dynamic model translation or type-erased message routing at run time.
+*
+* It has the same models, couplings and light filters as main.cpp, and the same build options
+* for them: LATENCY_PROBES, PROPORTIONAL_STEERING, INTERRUPT_CENTER_IR, SEPARATE_LIGHT_INPUTS and
+* TICK_TIME. What main.cpp has and this file does not:
+*   - logging: the runner uses not_logger, as main.cpp does with NO_LOGS or TELEMETRY
+*   - the ring buffer log drain and stdio through it
+*   - DEADLINE_MONITOR, MODEL_PROFILER and TELEMETRY (the decorators are not applied)
+*   - BINARY_TRACES and the input_filters.txt overrides (desktop only)
+*
+* Only built when STATIC_TOP_MODEL is defined ("make all_static" / "make embedded_static").
+*
+* With FIXED_MESSAGE_BAGS (on in both static builds) every port keeps its messages in inline
+* storage, so the steady-state control loop does no heap allocation. On target this is
+* checked with the mbed heap statistics after every STEADY_STATE_WINDOW of simulated time.
+*/
+#ifdef STATIC_TOP_MODEL
+
+#include <iostream>
+#include <chrono>
+#include <string>
+
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/coupled_model.hpp>
+#include <cadmium/engine/pdevs_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#ifdef TICK_TIME
+  #include "../utilities/tick_time.hpp"
+#else
+  #include <NDTime.hpp>
+#endif
+
+#include <cadmium/real_time/arm_mbed/io/digitalInput.hpp>
+#include <cadmium/real_time/arm_mbed/io/analogInput.hpp>
+#include <cadmium/real_time/arm_mbed/io/pwmOutput.hpp>
+#include <cadmium/real_time/arm_mbed/io/digitalOutput.hpp>
+
+#include "../atomics/lightBot.hpp"
+#include "../atomics/steeringBot.hpp"
+#include "../atomics/latencyProbe.hpp"
+#include "../atomics/filteredInput.hpp"
+#include "../atomics/interruptDigitalInput.hpp"
+#include "../atomics/dualAnalogInput.hpp"
+
+#ifdef FIXED_MESSAGE_BAGS
+  FIXED_MESSAGE_BAG(digitalInput_defs::out, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(analogInput_defs::out, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(pwmOutput_defs::in, FIXED_MESSAGE_BAG_CAPACITY)
+  FIXED_MESSAGE_BAG(digitalOutput_defs::in, FIXED_MESSAGE_BAG_CAPACITY)
+#endif
+
+#ifdef RT_ARM_MBED
+  #include "../mbed.h"
+#else
+  const char* A2  = "./inputs/A2_CenterIR_In.txt";
+  const char* A4  = "./inputs/A4_leftLightSens_In.txt";
+  const char* A5  = "./inputs/A5_rightLightSens_In.txt";
+  const char* D8  = "./outputs/D8_RightMotor1_Out.txt";
+  const char* D11 = "./outputs/D11_RightMotor2_Out.txt";
+  const char* D12 = "./outputs/D12_LeftMotor1_Out.txt";
+  const char* D13 = "./outputs/D13_LeftMotor2_Out.txt";
+#endif
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+// Build with -DTICK_TIME for integer microsecond time (utilities/tick_time.hpp)
+#ifdef TICK_TIME
+  using TIME = TickTime;
+#else
+  using TIME = NDTime;
+#endif
+
+/********************************************/
+/********* Pin bound I/O models *************/
+/********************************************/
+// Static models are default constructed and told apart by type,
+// so every pin gets its own model type that binds the pin in its constructor.
+// The latency_* decorators only measure when built with LATENCY_PROBES (see atomics/latencyProbe.hpp).
+
+#ifdef RT_ARM_MBED
+  // Motor driver enables.
+  DigitalOut rightMotorEn(D9);
+  DigitalOut leftMotorEn(D10);
+#endif
+
+// The center IR pin is polled every 100 ms like the other inputs. Build with -DINTERRUPT_CENTER_IR
+// to latch its edges in an interrupt instead (atomics/interruptDigitalInput.hpp).
+#ifdef INTERRUPT_CENTER_IR
+digital_input_stats centerIRStats;
+
+#ifdef RT_ARM_MBED
+template<typename T> class CenterIR : public latency_source<InterruptDigitalInput>::model<T> {
+  public: CenterIR() : latency_source<InterruptDigitalInput>::model<T>(instrumentation{"centerIR"}, A2, &centerIRStats) {}
+};
+#else
+// The latch is checked at the watchdog period, as on target.
+template<typename T> class CenterIR : public latency_source<InterruptDigitalInput>::model<T> {
+  public: CenterIR() : latency_source<InterruptDigitalInput>::model<T>(instrumentation{"centerIR"}, A2, &centerIRStats, INTERRUPT_INPUT_WATCHDOG_MS * 1000LL) {}
+};
+#endif
+#else
+template<typename T> class CenterIR : public latency_source<DigitalInput>::model<T> {
+  public: CenterIR() : latency_source<DigitalInput>::model<T>(instrumentation{"centerIR"}, A2) {}
+};
+#endif
+// Light sensor filtering (atomics/filteredInput.hpp): {deadband, decimation, minimum period in us}.
+// Off by default: a deadband can change LightBot's decisions, check a setting with FILTER_REPORT first.
+constexpr input_filter lightFilter = no_input_filter;
+
+// Both light sensors are read in one ADC scan and sent to LightBot as a light_pair
+// (atomics/dualAnalogInput.hpp). Build with -DSEPARATE_LIGHT_INPUTS for one AnalogInput per sensor.
+#ifdef SEPARATE_LIGHT_INPUTS
+template<typename T> using FilteredAnalogInput = filtered_input<AnalogInput>::model<T>;
+
+template<typename T> class RightLightSens : public latency_source<FilteredAnalogInput>::model<T> {
+  public: RightLightSens() : latency_source<FilteredAnalogInput>::model<T>(instrumentation{"rightLightSens", {}, lightFilter}, A5) {}
+};
+template<typename T> class LeftLightSens : public latency_source<FilteredAnalogInput>::model<T> {
+  public: LeftLightSens() : latency_source<FilteredAnalogInput>::model<T>(instrumentation{"leftLightSens", {}, lightFilter}, A4) {}
+};
+#else
+template<typename T> using FilteredDualAnalogInput = filtered_input<DualAnalogInput>::model<T>;
+
+template<typename T> class LightPair : public latency_source<FilteredDualAnalogInput>::model<T> {
+  public: LightPair() : latency_source<FilteredDualAnalogInput>::model<T>(instrumentation{"lightPair", {}, lightFilter}, A4, A5) {}
+};
+#endif
+template<typename T> class RightMotor1 : public latency_sink<PwmOutput>::model<T> {
+  public: RightMotor1() : latency_sink<PwmOutput>::model<T>(instrumentation{"rightMotor1"}, D11) {}
+};
+template<typename T> class RightMotor2 : public latency_sink<DigitalOutput>::model<T> {
+  public: RightMotor2() : latency_sink<DigitalOutput>::model<T>(instrumentation{"rightMotor2"}, D8) {}
+};
+template<typename T> class LeftMotor1 : public latency_sink<PwmOutput>::model<T> {
+  public: LeftMotor1() : latency_sink<PwmOutput>::model<T>(instrumentation{"leftMotor1"}, D13) {}
+};
+template<typename T> class LeftMotor2 : public latency_sink<DigitalOutput>::model<T> {
+  public: LeftMotor2() : latency_sink<DigitalOutput>::model<T>(instrumentation{"leftMotor2"}, D12) {}
+};
+// LightBot bang-bangs between left, straight and right. Build with -DPROPORTIONAL_STEERING to
+// steer with the PWM ports instead (atomics/steeringBot.hpp); the ports are the same.
+#ifdef PROPORTIONAL_STEERING
+  template<typename T> using LightController = SteeringBot<T>;
+#else
+  template<typename T> using LightController = LightBot<T>;
+#endif
+template<typename T> using Bot = latency_relay<LightController>::model<T>;
+
+/************************/
+/*******TOP MODEL********/
+/************************/
+using iports_TOP = std::tuple<>;
+using oports_TOP = std::tuple<>;
+
+#ifdef SEPARATE_LIGHT_INPUTS
+using submodels_TOP = cadmium::modeling::models_tuple<RightLightSens, LeftLightSens, Bot, CenterIR, RightMotor1, RightMotor2, LeftMotor1, LeftMotor2>;
+#else
+using submodels_TOP = cadmium::modeling::models_tuple<LightPair, Bot, CenterIR, RightMotor1, RightMotor2, LeftMotor1, LeftMotor2>;
+#endif
+
+using eics_TOP = std::tuple<>;
+using eocs_TOP = std::tuple<>;
+using ics_TOP = std::tuple<
+  cadmium::modeling::IC<Bot, lightBot_defs::rightMotor1, RightMotor1, pwmOutput_defs::in>,
+  cadmium::modeling::IC<Bot, lightBot_defs::rightMotor2, RightMotor2, digitalOutput_defs::in>,
+  cadmium::modeling::IC<Bot, lightBot_defs::leftMotor1, LeftMotor1, pwmOutput_defs::in>,
+  cadmium::modeling::IC<Bot, lightBot_defs::leftMotor2, LeftMotor2, digitalOutput_defs::in>,
+
+#ifdef SEPARATE_LIGHT_INPUTS
+  cadmium::modeling::IC<RightLightSens, analogInput_defs::out, Bot, lightBot_defs::rightLightSens>,
+  cadmium::modeling::IC<LeftLightSens, analogInput_defs::out, Bot, lightBot_defs::leftLightSens>,
+#else
+  cadmium::modeling::IC<LightPair, dualAnalogInput_defs::out, Bot, lightBot_defs::lightPair>,
+#endif
+
+  cadmium::modeling::IC<CenterIR, digitalInput_defs::out, Bot, lightBot_defs::centerIR>
+>;
+
+template<typename T>
+using TOP = cadmium::modeling::pdevs::coupled_model<T, iports_TOP, oports_TOP, submodels_TOP, eics_TOP, eocs_TOP, ics_TOP>;
+
+int main(int argc, char ** argv) {
+
+  #ifdef RT_ARM_MBED
+    //Enable the motors:
+    rightMotorEn = 1;
+    leftMotorEn = 1;
+  #else
+    auto start = hclock::now(); //to measure simulation execution time
+  #endif
+
+  cadmium::engine::runner<TIME, TOP, cadmium::logger::not_logger> r{TIME({0})};
+
+  #ifdef LATENCY_PROBES
+    latency_probe::start();
+  #endif
+
+  #if defined(RT_ARM_MBED) && defined(FIXED_MESSAGE_BAGS) && defined(MBED_HEAP_STATS_ENABLED)
+    // The first window warms up (first samples, lazily created objects), after that
+    // no window may allocate: total_size only grows when something is allocated.
+    const TIME end({0, 10, 0, 0});
+    const TIME window({0, 0, 10, 0});
+    TIME next = window;
+    r.run_until(next);
+    mbed_stats_heap_t before;
+    mbed_stats_heap_get(&before);
+    while(next < end) {
+      next = next + window;
+      r.run_until(next);
+      mbed_stats_heap_t after;
+      mbed_stats_heap_get(&after);
+      if(after.total_size != before.total_size) {
+        printf("Heap allocation in the control loop: %lu bytes\n", (unsigned long) (after.total_size - before.total_size));
+      }
+      MBED_ASSERT(after.total_size == before.total_size);
+      before = after;
+    }
+  #else
+    #ifndef RT_ARM_MBED
+      auto run_start = hclock::now();
+    #endif
+    r.run_until(TIME({0, 10, 0, 0}));
+    #ifndef RT_ARM_MBED
+      const double run_seconds = chrono::duration_cast<chrono::duration<double>>(hclock::now() - run_start).count();
+    #endif
+  #endif
+
+  // Light sensor samples read and sent to LightBot
+  input_filter_stats::report(stdout);
+
+  #ifdef INTERRUPT_CENTER_IR
+    printf("centerIR         wakeups %10lu  edges %10lu  sent %10lu\n", centerIRStats.wakeups, centerIRStats.edges, centerIRStats.sent);
+  #endif
+
+  #ifdef RT_ARM_MBED
+    if(light_pair_scanner::timeouts() > 0) {
+      printf("lightPair        scan timeouts %lu (read with AnalogIn)\n", light_pair_scanner::timeouts());
+    }
+  #endif
+
+  #ifdef LATENCY_PROBES
+    // Sensor to motor latency histograms, one per motor output
+    #ifdef RT_ARM_MBED
+      latency_probe::report(stdout);
+    #else
+      FILE* latency_file = fopen("latency_report.txt", "w");
+      if(latency_file) {
+        latency_probe::report(latency_file);
+        fclose(latency_file);
+      }
+    #endif
+  #endif
+
+  #ifndef RT_ARM_MBED
+    cout << "Run took: " << run_seconds << " s" << endl;
+    cout << "Simulation took: " << chrono::duration_cast<chrono::duration<double>>(hclock::now() - start).count() << " s" << endl;
+    return 0;
+  #endif
+}
+#endif // STATIC_TOP_MODEL
@@ -0,0 +1,166 @@
+/**
+* ARSLab - Carleton University
+*
+* Replay:
+* Runs the desktop LightBot system of main.cpp on recorded input traces as fast as possible,
+* with logging off and no output files. The motor ports go straight to golden comparators
+* (atomics/goldenOutput.hpp) that check them against reference pin files, and the first
+* divergence of each pin is printed. The exit code is 1 if any pin diverges, so it can gate
+* a controller change.
+*
+*   ./SEEED_BOT_REPLAY [-i inputs] [-g outputs] [-u 00:10:00:000] [-b]
+*
+* -i holds the input traces and -g the reference outputs (same file names as inputs/ and
+* outputs/, the defaults). -b replays the binary traces (.sbt, "make binary_traces") instead
+* of the text files.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <cadmium/modeling/coupling.hpp>
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/concept/coupled_model_assert.hpp>
+#include <cadmium/modeling/dynamic_coupled.hpp>
+#include <cadmium/modeling/dynamic_atomic.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#ifdef TICK_TIME
+  #include "../utilities/tick_time.hpp"
+#else
+  #include <NDTime.hpp>
+#endif
+
+#include <cadmium/real_time/arm_mbed/io/digitalInput.hpp>
+#include <cadmium/real_time/arm_mbed/io/analogInput.hpp>
+
+#include "../atomics/lightBot.hpp"
+#include "../atomics/filteredInput.hpp"
+#include "../atomics/interruptDigitalInput.hpp"
+#include "../atomics/dualAnalogInput.hpp"
+#include "../atomics/binaryTraceInput.hpp"
+#include "../atomics/goldenOutput.hpp"
+#include "../utilities/time_conversion.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+#ifdef TICK_TIME
+  using TIME = TickTime;
+#else
+  using TIME = NDTime;
+#endif
+
+template<typename T> using FilteredDualAnalogInput = filtered_input<DualAnalogInput>::model<T>;
+template<typename T> using FilteredBinaryAnalogInput = filtered_input<BinaryAnalogInput>::model<T>;
+
+static void usage() {
+  cerr << "usage: SEEED_BOT_REPLAY [-i inputs] [-g outputs] [-u 00:10:00:000] [-b]" << endl;
+  exit(2);
+}
+
+int main(int argc, char ** argv) {
+  string inputs = "./inputs";
+  string golden = "./outputs";
+  string until_text = "00:10:00:000";
+  bool binary = false;
+  for(int i = 1; i < argc; i++) {
+    const string arg = argv[i];
+    if(arg == "-b") { binary = true; continue; }
+    if(i + 1 >= argc) usage();
+    if(arg == "-i") inputs = argv[++i];
+    else if(arg == "-g") golden = argv[++i];
+    else if(arg == "-u") until_text = argv[++i];
+    else usage();
+  }
+
+  // Same pins as main.cpp: rightMotor1 -> D11, rightMotor2 -> D8, leftMotor1 -> D13, leftMotor2 -> D12
+  golden_pin_check d8("D8", (golden + "/D8_RightMotor1_Out.txt").c_str());
+  golden_pin_check d11("D11", (golden + "/D11_RightMotor2_Out.txt").c_str());
+  golden_pin_check d12("D12", (golden + "/D12_LeftMotor1_Out.txt").c_str());
+  golden_pin_check d13("D13", (golden + "/D13_LeftMotor2_Out.txt").c_str());
+
+  using AtomicModelPtr=std::shared_ptr<cadmium::dynamic::modeling::model>;
+  using CoupledModelPtr=std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>>;
+
+  // The input filter of main.cpp, with the overrides of input_filters.txt if there is one.
+  input_filter lightFilter = no_input_filter;
+  input_filter rightLightFilter = lightFilter;
+  input_filter leftLightFilter = lightFilter;
+  load_input_filters("input_filters.txt", "lightPair", lightFilter);
+  load_input_filters("input_filters.txt", "rightLightSens", rightLightFilter);
+  load_input_filters("input_filters.txt", "leftLightSens", leftLightFilter);
+
+  AtomicModelPtr lightBot = cadmium::dynamic::translate::make_dynamic_atomic_model<LightBot, TIME>("lightBot");
+  AtomicModelPtr rightMotor1 = cadmium::dynamic::translate::make_dynamic_atomic_model<GoldenPwmOutput, TIME>("rightMotor1", &d11);
+  AtomicModelPtr rightMotor2 = cadmium::dynamic::translate::make_dynamic_atomic_model<GoldenDigitalOutput, TIME>("rightMotor2", &d8);
+  AtomicModelPtr leftMotor1 = cadmium::dynamic::translate::make_dynamic_atomic_model<GoldenPwmOutput, TIME>("leftMotor1", &d13);
+  AtomicModelPtr leftMotor2 = cadmium::dynamic::translate::make_dynamic_atomic_model<GoldenDigitalOutput, TIME>("leftMotor2", &d12);
+
+  cadmium::dynamic::modeling::Models submodels_TOP = {lightBot, rightMotor1, rightMotor2, leftMotor1, leftMotor2};
+  cadmium::dynamic::modeling::ICs ics_TOP = {
+     cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor1, goldenPwmOutput_defs::in>("lightBot","rightMotor1"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor2, goldenDigitalOutput_defs::in>("lightBot","rightMotor2"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor1, goldenPwmOutput_defs::in>("lightBot","leftMotor1"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor2, goldenDigitalOutput_defs::in>("lightBot","leftMotor2")
+  };
+
+  // Inputs as main.cpp builds them: text traces with the paired light input and the
+  // edge-triggered center IR, binary traces (BINARY_TRACES) with one model per pin.
+  if(binary) {
+    const string A2 = inputs + "/A2_CenterIR_In.sbt";
+    const string A4 = inputs + "/A4_leftLightSens_In.sbt";
+    const string A5 = inputs + "/A5_rightLightSens_In.sbt";
+    submodels_TOP.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<BinaryDigitalInput, TIME>("centerIR", A2.c_str()));
+    submodels_TOP.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<FilteredBinaryAnalogInput, TIME>("rightLightSens", instrumentation{"rightLightSens", {}, rightLightFilter}, A5.c_str()));
+    submodels_TOP.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<FilteredBinaryAnalogInput, TIME>("leftLightSens", instrumentation{"leftLightSens", {}, leftLightFilter}, A4.c_str()));
+    ics_TOP.push_back(cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::rightLightSens>("rightLightSens", "lightBot"));
+    ics_TOP.push_back(cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::leftLightSens>("leftLightSens", "lightBot"));
+  } else {
+    const string A2 = inputs + "/A2_CenterIR_In.txt";
+    const string A4 = inputs + "/A4_leftLightSens_In.txt";
+    const string A5 = inputs + "/A5_rightLightSens_In.txt";
+    submodels_TOP.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<DigitalInput, TIME>("centerIR", A2.c_str()));
+    submodels_TOP.push_back(cadmium::dynamic::translate::make_dynamic_atomic_model<FilteredDualAnalogInput, TIME>("lightPair", instrumentation{"lightPair", {}, lightFilter}, A4.c_str(), A5.c_str()));
+    ics_TOP.push_back(cadmium::dynamic::translate::make_IC<dualAnalogInput_defs::out, lightBot_defs::lightPair>("lightPair", "lightBot"));
+  }
+  ics_TOP.push_back(cadmium::dynamic::translate::make_IC<digitalInput_defs::out, lightBot_defs::centerIR>("centerIR", "lightBot"));
+
+  cadmium::dynamic::modeling::Ports iports_TOP = {};
+  cadmium::dynamic::modeling::Ports oports_TOP = {};
+  cadmium::dynamic::modeling::EICs eics_TOP = {};
+  cadmium::dynamic::modeling::EOCs eocs_TOP = {};
+  CoupledModelPtr TOP = std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
+   "TOP",
+   submodels_TOP,
+   iports_TOP,
+   oports_TOP,
+   eics_TOP,
+   eocs_TOP,
+   ics_TOP
+   );
+
+  const TIME until(until_text);
+  auto start = hclock::now();
+  cadmium::dynamic::engine::runner<TIME, cadmium::logger::not_logger> r(TOP, {0});
+  r.run_until(until);
+  const double seconds = chrono::duration_cast<chrono::duration<double>>(hclock::now() - start).count();
+
+  const long long end_us = to_microseconds(until);
+  golden_pin_check* pins[] = {&d8, &d11, &d12, &d13};
+  bool diverged = false;
+  for(golden_pin_check* pin : pins) {
+    pin->finish(end_us);
+    pin->report(stdout);
+    diverged = diverged || pin->diverged();
+  }
+  printf("Replayed %s of %s in %.3f s (%.0fx real time)\n", until_text.c_str(), inputs.c_str(), seconds,
+         seconds > 0 ? end_us / 1e6 / seconds : 0.0);
+  return diverged ? 1 : 0;
+}
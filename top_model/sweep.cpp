@@ -0,0 +1,222 @@
+/**
+* ARSLab - Carleton University
+*
+* Sweep:
+* Headless batch runner for the LightBot controller. Every scenario is a directory holding the
+* three sensor traces (same file names as inputs/). Each scenario is run once per light
+* threshold, every run gets its own TOP model and runner, and runs are spread over a thread pool.
+* Instead of logs and output pin files, one line of summary metrics is written per run.
+*
+*   ./SEEED_BOT_SWEEP <scenarios dir> [-t 0.05,0.1,0.2] [-u 00:10:00:000] [-j threads] [-o summary.csv]
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <cadmium/modeling/coupling.hpp>
+#include <cadmium/modeling/ports.hpp>
+#include <cadmium/modeling/dynamic_model_translator.hpp>
+#include <cadmium/concept/coupled_model_assert.hpp>
+#include <cadmium/modeling/dynamic_coupled.hpp>
+#include <cadmium/modeling/dynamic_atomic.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+#include <NDTime.hpp>
+
+#include <cadmium/real_time/arm_mbed/io/digitalInput.hpp>
+#include <cadmium/real_time/arm_mbed/io/analogInput.hpp>
+
+#include "../atomics/lightBot.hpp"
+#include "../atomics/driveMonitor.hpp"
+#include "../utilities/time_conversion.hpp"
+
+using namespace std;
+
+using hclock=chrono::high_resolution_clock;
+using TIME = NDTime;
+
+struct sweep_run {
+  string scenario;
+  float threshold;
+  drive_metrics metrics;
+  double seconds; // wall clock
+  string error;
+};
+
+static bool is_file(const string& path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static bool is_scenario(const string& dir) {
+  return is_file(dir + "/A2_CenterIR_In.txt") && is_file(dir + "/A4_leftLightSens_In.txt") && is_file(dir + "/A5_rightLightSens_In.txt");
+}
+
+// The directory itself if it holds a trace set, otherwise every subdirectory that does.
+static vector<string> find_scenarios(const string& root) {
+  vector<string> scenarios;
+  if(is_scenario(root)) {
+    scenarios.push_back(root);
+    return scenarios;
+  }
+  DIR* dir = opendir(root.c_str());
+  if(!dir) return scenarios;
+  while(dirent* entry = readdir(dir)) {
+    const string name = entry->d_name;
+    if(name == "." || name == "..") continue;
+    if(is_scenario(root + "/" + name)) scenarios.push_back(root + "/" + name);
+  }
+  closedir(dir);
+  sort(scenarios.begin(), scenarios.end());
+  return scenarios;
+}
+
+static void run_scenario(sweep_run& run, const TIME& until) {
+  const string A2 = run.scenario + "/A2_CenterIR_In.txt";
+  const string A4 = run.scenario + "/A4_leftLightSens_In.txt";
+  const string A5 = run.scenario + "/A5_rightLightSens_In.txt";
+
+  using AtomicModelPtr=std::shared_ptr<cadmium::dynamic::modeling::model>;
+  using CoupledModelPtr=std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>>;
+
+  AtomicModelPtr lightBot = cadmium::dynamic::translate::make_dynamic_atomic_model<LightBot, TIME>("lightBot", true, run.threshold);
+  AtomicModelPtr centerIR = cadmium::dynamic::translate::make_dynamic_atomic_model<DigitalInput, TIME>("centerIR", A2.c_str());
+  AtomicModelPtr rightLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<AnalogInput, TIME>("rightLightSens", A5.c_str());
+  AtomicModelPtr leftLightSens = cadmium::dynamic::translate::make_dynamic_atomic_model<AnalogInput, TIME>("leftLightSens", A4.c_str());
+  AtomicModelPtr monitor = cadmium::dynamic::translate::make_dynamic_atomic_model<DriveMonitor, TIME>("monitor", &run.metrics);
+
+  cadmium::dynamic::modeling::Ports iports_TOP = {};
+  cadmium::dynamic::modeling::Ports oports_TOP = {};
+  cadmium::dynamic::modeling::Models submodels_TOP = {rightLightSens, leftLightSens, lightBot, centerIR, monitor};
+  cadmium::dynamic::modeling::EICs eics_TOP = {};
+  cadmium::dynamic::modeling::EOCs eocs_TOP = {};
+  cadmium::dynamic::modeling::ICs ics_TOP = {
+     cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor1, driveMonitor_defs::rightMotor1>("lightBot","monitor"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::rightMotor2, driveMonitor_defs::rightMotor2>("lightBot","monitor"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor1, driveMonitor_defs::leftMotor1>("lightBot","monitor"),
+     cadmium::dynamic::translate::make_IC<lightBot_defs::leftMotor2, driveMonitor_defs::leftMotor2>("lightBot","monitor"),
+
+     cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::rightLightSens>("rightLightSens", "lightBot"),
+     cadmium::dynamic::translate::make_IC<analogInput_defs::out, lightBot_defs::leftLightSens>("leftLightSens", "lightBot"),
+
+     cadmium::dynamic::translate::make_IC<digitalInput_defs::out, lightBot_defs::centerIR>("centerIR", "lightBot")
+  };
+  CoupledModelPtr TOP = std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(
+   "TOP",
+   submodels_TOP,
+   iports_TOP,
+   oports_TOP,
+   eics_TOP,
+   eocs_TOP,
+   ics_TOP
+   );
+
+  auto start = hclock::now();
+  cadmium::dynamic::engine::runner<TIME, cadmium::logger::not_logger> r(TOP, {0});
+  r.run_until(until);
+  run.metrics.finish(to_microseconds(until));
+  run.seconds = chrono::duration_cast<chrono::duration<double>>(hclock::now() - start).count();
+}
+
+static vector<float> parse_thresholds(const string& list) {
+  vector<float> thresholds;
+  stringstream ss(list);
+  string item;
+  while(getline(ss, item, ',')) {
+    if(!item.empty()) thresholds.push_back(strtof(item.c_str(), nullptr));
+  }
+  return thresholds;
+}
+
+static void usage() {
+  cerr << "usage: SEEED_BOT_SWEEP <scenarios dir> [-t 0.05,0.1,0.2] [-u 00:10:00:000] [-j threads] [-o summary.csv]" << endl;
+  exit(2);
+}
+
+int main(int argc, char ** argv) {
+  if(argc < 2) usage();
+  const string root = argv[1];
+  vector<float> thresholds = {0.1};
+  string until_text = "00:10:00:000";
+  string out_path = "sweep_summary.csv";
+  unsigned threads = max(1u, thread::hardware_concurrency());
+
+  for(int i = 2; i < argc; i++) {
+    const string arg = argv[i];
+    if(i + 1 >= argc) usage();
+    if(arg == "-t") thresholds = parse_thresholds(argv[++i]);
+    else if(arg == "-u") until_text = argv[++i];
+    else if(arg == "-j") threads = max(1, atoi(argv[++i]));
+    else if(arg == "-o") out_path = argv[++i];
+    else usage();
+  }
+
+  const vector<string> scenarios = find_scenarios(root);
+  if(scenarios.empty() || thresholds.empty()) {
+    cerr << "No scenarios found in " << root << endl;
+    return 1;
+  }
+
+  vector<sweep_run> runs;
+  for(const string& scenario : scenarios) {
+    for(float threshold : thresholds) {
+      sweep_run run;
+      run.scenario = scenario;
+      run.threshold = threshold;
+      run.seconds = 0;
+      runs.push_back(run);
+    }
+  }
+
+  const TIME until(until_text);
+  atomic<size_t> next(0);
+  mutex progress_mutex;
+  size_t done = 0;
+  auto start = hclock::now();
+
+  vector<thread> pool;
+  for(unsigned t = 0; t < min<size_t>(threads, runs.size()); t++) {
+    pool.emplace_back([&]() {
+      for(size_t i = next++; i < runs.size(); i = next++) {
+        try {
+          run_scenario(runs[i], until);
+        } catch(const exception& e) {
+          runs[i].error = e.what();
+        }
+        lock_guard<mutex> lock(progress_mutex);
+        done++;
+        if(done % 100 == 0 || done == runs.size()) {
+          cout << done << "/" << runs.size() << " runs" << endl;
+        }
+      }
+    });
+  }
+  for(thread& t : pool) t.join();
+
+  ofstream out(out_path);
+  out << "scenario,threshold,right_s,straight_s,left_s,stop_s,dir_changes,flips,motor_messages,wall_s,error" << "\n";
+  for(const sweep_run& run : runs) {
+    const drive_metrics& m = run.metrics;
+    out << run.scenario << "," << run.threshold << ","
+        << m.time_us[(int) DriveState::right] / 1e6 << "," << m.time_us[(int) DriveState::straight] / 1e6 << ","
+        << m.time_us[(int) DriveState::left] / 1e6 << "," << m.time_us[(int) DriveState::stop] / 1e6 << ","
+        << m.changes << "," << m.flips << "," << m.commands << "," << run.seconds << "," << run.error << "\n";
+  }
+
+  const double elapsed = chrono::duration_cast<chrono::duration<double>>(hclock::now() - start).count();
+  cout << runs.size() << " runs on " << pool.size() << " threads in " << elapsed << " s, summary in " << out_path << endl;
+  return 0;
+}
@@ -0,0 +1,84 @@
+/**
+* ARSLab - Carleton University
+*
+* Telemetry Decoder:
+* Rebuilds the pin trace files of a run from a telemetry capture (utilities/telemetry.hpp),
+* e.g. the serial output of a target built with -DTELEMETRY. The files have the names of
+* inputs/ and outputs/ and can be replayed by SEEED_BOT_TOP or shown by SVEC.py.
+*
+*   ./TELEMETRY_DECODE <capture> [out dir]
+*
+* Each pin file gets one "HH:MM:SS:mmm value" line per change; repeated values are dropped.
+* Text logged on the same port is skipped.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "../utilities/telemetry.hpp"
+#include "../utilities/time_conversion.hpp"
+
+using namespace std;
+
+int main(int argc, char ** argv) {
+  if(argc < 2 || argc > 3) {
+    cerr << "usage: TELEMETRY_DECODE <capture> [out dir]" << endl;
+    return 2;
+  }
+  const string dir = argc == 3 ? argv[2] : "field_run";
+
+  ifstream in(argv[1], ios::binary);
+  if(!in) {
+    cerr << "Cannot open " << argv[1] << endl;
+    return 1;
+  }
+  const vector<uint8_t> capture((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+  mkdir(dir.c_str(), 0755);
+  mkdir((dir + "/inputs").c_str(), 0755);
+  mkdir((dir + "/outputs").c_str(), 0755);
+
+  FILE* files[telemetry::pins];
+  float last[telemetry::pins];
+  bool seen[telemetry::pins];
+  unsigned long lines[telemetry::pins];
+  for(int p = 0; p < telemetry::pins; p++) {
+    const string path = dir + "/" + telemetry::file_name((telemetry_pin) p);
+    files[p] = fopen(path.c_str(), "w");
+    if(!files[p]) {
+      cerr << "Cannot write " << path << endl;
+      return 1;
+    }
+    seen[p] = false;
+    lines[p] = 0;
+  }
+
+  TelemetryDecoder decoder;
+  decoder.decode(capture.data(), capture.size(), [&](telemetry_pin pin, long long time_us, float value) {
+    const int p = (int) pin;
+    if(seen[p] && last[p] == value) return;
+    seen[p] = true;
+    last[p] = value;
+    lines[p]++;
+    if(telemetry::is_digital(pin)) {
+      fprintf(files[p], "%s %d\n", format_time_string(time_us).c_str(), value != 0 ? 1 : 0);
+    } else {
+      fprintf(files[p], "%s %.4g\n", format_time_string(time_us).c_str(), value);
+    }
+  });
+
+  for(int p = 0; p < telemetry::pins; p++) {
+    fclose(files[p]);
+    printf("%-32s %8lu changes\n", telemetry::file_name((telemetry_pin) p), lines[p]);
+  }
+  printf("%lu frames, %lu records, %lu bad frames skipped, %zu bytes\n", decoder.frame_count(), decoder.record_count(),
+         decoder.bad_frame_count(), capture.size());
+  return 0;
+}
@@ -0,0 +1,108 @@
+/**
+* ARSLab - Carleton University
+*
+* Trace Converter:
+* Converts pin trace files between the text format used in inputs/ and outputs/
+* ("HH:MM:SS:mmm value" per line) and the binary trace format (utilities/binary_trace.hpp).
+*
+*   ./TRACE_CONVERT to-binary analog|digital <in.txt> <out.sbt>
+*   ./TRACE_CONVERT to-text <in.sbt> <out.txt>
+*/
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "../utilities/binary_trace.hpp"
+#include "../utilities/time_conversion.hpp"
+
+using namespace std;
+
+template<typename VALUE>
+static long long text_to_binary(const char* in_path, const char* out_path) {
+  ifstream in(in_path);
+  if(!in) {
+    cerr << "Cannot open " << in_path << endl;
+    exit(1);
+  }
+  ofstream out(out_path, ios::binary | ios::trunc);
+  BinaryTraceWriter<VALUE> writer(out);
+
+  string line;
+  long long count = 0;
+  long long line_number = 0;
+  while(getline(in, line)) {
+    line_number++;
+    const char* rest;
+    long long us;
+    if(!parse_time_string(line.c_str(), us, &rest)) {
+      if(line.find_first_not_of(" \t\r") == string::npos) continue;
+      cerr << in_path << ":" << line_number << ": expected a time" << endl;
+      exit(1);
+    }
+    writer.write(us, (VALUE) strtof(rest, nullptr));
+    count++;
+  }
+  writer.finish();
+  return count;
+}
+
+template<typename VALUE>
+static long long binary_to_text(const char* in_path, const char* out_path) {
+  BinaryTraceReader<VALUE> reader(in_path);
+  ofstream out(out_path, ios::trunc);
+  // Enough digits for the text to read back to the same float.
+  out << setprecision(numeric_limits<float>::max_digits10);
+  long long count = 0;
+  long long us;
+  VALUE value;
+  while(reader.next(us, value)) {
+    out << format_time_string(us) << " " << value << "\n";
+    count++;
+  }
+  return count;
+}
+
+static void usage() {
+  cerr << "usage: TRACE_CONVERT to-binary analog|digital <in.txt> <out.sbt>" << endl;
+  cerr << "       TRACE_CONVERT to-text <in.sbt> <out.txt>" << endl;
+  exit(2);
+}
+
+int main(int argc, char ** argv) {
+  if(argc < 2) usage();
+  const string mode = argv[1];
+  long long count;
+
+  try {
+    if(mode == "to-binary" && argc == 5) {
+      const string kind = argv[2];
+      if(kind == "analog") {
+        count = text_to_binary<float>(argv[3], argv[4]);
+      } else if(kind == "digital") {
+        count = text_to_binary<bool>(argv[3], argv[4]);
+      } else {
+        usage();
+      }
+    } else if(mode == "to-text" && argc == 4) {
+      trace_kind kind;
+      if(!peek_trace_kind(argv[2], kind)) {
+        cerr << argv[2] << " is not a binary trace" << endl;
+        return 1;
+      }
+      count = kind == trace_kind::analog ? binary_to_text<float>(argv[2], argv[3])
+                                         : binary_to_text<bool>(argv[2], argv[3]);
+    } else {
+      usage();
+    }
+  } catch(const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  cout << count << " samples converted" << endl;
+  return 0;
+}
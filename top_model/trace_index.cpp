@@ -0,0 +1,80 @@
+/**
+* ARSLab - Carleton University
+*
+* Trace Index:
+* Builds and queries the sidecar time index of the text traces (utilities/trace_index.hpp):
+* the pin files of inputs/ and outputs/ and the seeed_bot_test_output.txt log. Queries build
+* the index first if it is missing or out of date, then only read the blocks they need.
+*
+*   ./TRACE_INDEX build [-b events per block] <trace>...
+*   ./TRACE_INDEX window <from> <to> <trace>        lines of the events in [from, to]
+*   ./TRACE_INDEX at <time> <trace>...              value of each pin file at time
+*
+* Times are "HH:MM:SS:mmm" (":uuu" optional). at prints one "<trace> <value>" line per file,
+* "-" when the trace starts after the time.
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "../utilities/trace_index.hpp"
+#include "../utilities/time_conversion.hpp"
+
+using namespace std;
+
+static void usage() {
+  cerr << "usage: TRACE_INDEX build [-b events per block] <trace>..." << endl;
+  cerr << "       TRACE_INDEX window <from> <to> <trace>" << endl;
+  cerr << "       TRACE_INDEX at <time> <trace>..." << endl;
+  exit(2);
+}
+
+static long long parse_time(const char* text) {
+  long long us;
+  if(!parse_time_string(text, us)) {
+    cerr << "Not a time: " << text << endl;
+    exit(2);
+  }
+  return us;
+}
+
+int main(int argc, char ** argv) {
+  if(argc < 3) usage();
+  const string mode = argv[1];
+
+  try {
+    if(mode == "build") {
+      int first = 2;
+      uint32_t block_size = trace_index::default_block_size;
+      if(string(argv[2]) == "-b") {
+        if(argc < 5) usage();
+        block_size = (uint32_t) strtoul(argv[3], nullptr, 10);
+        first = 4;
+      }
+      for(int i = first; i < argc; i++) {
+        const TraceIndex index = TraceIndex::build(argv[i], block_size);
+        index.save();
+        cout << argv[i] << ": " << index.events() << " events, " << index.blocks().size() << " blocks" << endl;
+      }
+    } else if(mode == "window" && argc == 5) {
+      const TraceIndex index = TraceIndex::open(argv[4]);
+      index.window(parse_time(argv[2]), parse_time(argv[3]), [](long long, const string& line) {
+        cout << line << "\n";
+      });
+    } else if(mode == "at" && argc >= 4) {
+      const long long time_us = parse_time(argv[2]);
+      for(int i = 3; i < argc; i++) {
+        const TraceIndex index = TraceIndex::open(argv[i]);
+        string value;
+        cout << argv[i] << " " << (index.value_at(time_us, value) ? value : "-") << "\n";
+      }
+    } else {
+      usage();
+    }
+  } catch(const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,250 @@
+/**
+* ARSLab - Carleton University
+*
+* Binary Trace:
+* Compact, delta-encoded format for the pin input/output traces.
+*
+* Layout (little endian):
+*   header   "SBT1" | kind (u8, 0 = analog float, 1 = digital bool) | 3 reserved bytes | sample count (u64)
+*   analog   per sample: varint(time delta in microseconds) | float32 value
+*   digital  per group of up to 8 samples: u8 value bits (bit i = sample i) | varint time delta per sample
+*
+* Time deltas are relative to the previous sample (the first one to time 0) and must not be negative.
+* The reader memory-maps the file and decodes it sample by sample, so it is only built on desktop.
+*/
+#ifndef SEEED_BOT_BINARY_TRACE_HPP
+#define SEEED_BOT_BINARY_TRACE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#ifndef RT_ARM_MBED
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+enum class trace_kind : uint8_t {analog = 0, digital = 1};
+
+template<typename VALUE> struct trace_value;
+template<> struct trace_value<float> { static constexpr trace_kind kind = trace_kind::analog; };
+template<> struct trace_value<bool> { static constexpr trace_kind kind = trace_kind::digital; };
+
+namespace binary_trace {
+  constexpr char magic[4] = {'S', 'B', 'T', '1'};
+  constexpr std::size_t header_size = 16;
+
+  inline void put_varint(std::ostream& os, uint64_t v) {
+    while(v >= 0x80) {
+      os.put((char) ((v & 0x7F) | 0x80));
+      v >>= 7;
+    }
+    os.put((char) v);
+  }
+
+  inline bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for(int shift = 0; p < end && shift < 64; shift += 7) {
+      const uint8_t b = *p++;
+      v |= (uint64_t) (b & 0x7F) << shift;
+      if(!(b & 0x80)) return true;
+    }
+    return false;
+  }
+
+  inline void put_u64(std::ostream& os, uint64_t v) {
+    for(int i = 0; i < 8; i++) os.put((char) ((v >> (8 * i)) & 0xFF));
+  }
+
+  inline uint64_t get_u64(const uint8_t* p) {
+    uint64_t v = 0;
+    for(int i = 0; i < 8; i++) v |= (uint64_t) p[i] << (8 * i);
+    return v;
+  }
+
+  inline void put_float(std::ostream& os, float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    for(int i = 0; i < 4; i++) os.put((char) ((bits >> (8 * i)) & 0xFF));
+  }
+
+  inline float get_float(const uint8_t* p) {
+    uint32_t bits = 0;
+    for(int i = 0; i < 4; i++) bits |= (uint32_t) p[i] << (8 * i);
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+  }
+}
+
+// Streams samples to a seekable output stream. finish() must be called to write the sample count.
+template<typename VALUE>
+class BinaryTraceWriter {
+    public:
+        explicit BinaryTraceWriter(std::ostream& output) : os(output), last_us(0), count(0), group_bits(0), group_size(0) {
+          os.write(binary_trace::magic, 4);
+          os.put((char) trace_value<VALUE>::kind);
+          os.put(0); os.put(0); os.put(0);
+          count_pos = os.tellp();
+          binary_trace::put_u64(os, 0);
+        }
+
+        void write(long long time_us, VALUE value) {
+          if(time_us < last_us) {
+            throw std::invalid_argument("binary trace samples must be in time order");
+          }
+          const uint64_t delta = (uint64_t) (time_us - last_us);
+          last_us = time_us;
+          count++;
+          append(delta, value);
+        }
+
+        void finish() {
+          flush_group();
+          const std::streampos end = os.tellp();
+          os.seekp(count_pos);
+          binary_trace::put_u64(os, count);
+          os.seekp(end);
+          os.flush();
+        }
+
+    private:
+        void append(uint64_t delta, float value) {
+          binary_trace::put_varint(os, delta);
+          binary_trace::put_float(os, value);
+        }
+
+        void append(uint64_t delta, bool value) {
+          group_deltas[group_size] = delta;
+          if(value) group_bits |= (uint8_t) (1u << group_size);
+          if(++group_size == 8) flush_group();
+        }
+
+        void flush_group() {
+          if(group_size == 0) return;
+          os.put((char) group_bits);
+          for(int i = 0; i < group_size; i++) binary_trace::put_varint(os, group_deltas[i]);
+          group_bits = 0;
+          group_size = 0;
+        }
+
+        std::ostream& os;
+        std::streampos count_pos;
+        long long last_us;
+        uint64_t count;
+        uint64_t group_deltas[8];
+        uint8_t group_bits;
+        int group_size;
+};
+
+#ifndef RT_ARM_MBED
+// Memory-mapped, streaming reader. Decodes one sample per next() call.
+template<typename VALUE>
+class BinaryTraceReader {
+    public:
+        explicit BinaryTraceReader(const char* path) : data(nullptr), size(0), remaining(0), time_us(0), group_bits(0), group_left(0) {
+          const int fd = ::open(path, O_RDONLY);
+          if(fd < 0) {
+            throw std::runtime_error(std::string("cannot open binary trace ") + path);
+          }
+          struct stat st;
+          if(::fstat(fd, &st) == 0 && st.st_size > 0) {
+            size = (std::size_t) st.st_size;
+            void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            data = map == MAP_FAILED ? nullptr : (const uint8_t*) map;
+          }
+          ::close(fd);
+          if(!data || size < binary_trace::header_size || std::memcmp(data, binary_trace::magic, 4) != 0) {
+            release();
+            throw std::runtime_error(std::string("not a binary trace: ") + path);
+          }
+          if(data[4] != (uint8_t) trace_value<VALUE>::kind) {
+            release();
+            throw std::runtime_error(std::string("binary trace has the wrong pin kind: ") + path);
+          }
+          #ifdef MADV_SEQUENTIAL
+            ::madvise((void*) data, size, MADV_SEQUENTIAL);
+          #endif
+          remaining = binary_trace::get_u64(data + 8);
+          cursor = data + binary_trace::header_size;
+          end = data + size;
+        }
+
+        BinaryTraceReader(const BinaryTraceReader&) = delete;
+        BinaryTraceReader& operator=(const BinaryTraceReader&) = delete;
+
+        ~BinaryTraceReader() {
+          release();
+        }
+
+        uint64_t samples_left() const { return remaining; }
+
+        // Returns false at the end of the trace.
+        bool next(long long& sample_us, VALUE& value) {
+          if(remaining == 0) return false;
+          if(!decode(value)) {
+            throw std::runtime_error("truncated binary trace");
+          }
+          remaining--;
+          sample_us = time_us;
+          return true;
+        }
+
+    private:
+        bool decode(float& value) {
+          uint64_t delta;
+          if(!binary_trace::get_varint(cursor, end, delta) || end - cursor < 4) return false;
+          time_us += (long long) delta;
+          value = binary_trace::get_float(cursor);
+          cursor += 4;
+          return true;
+        }
+
+        bool decode(bool& value) {
+          if(group_left == 0) {
+            if(cursor >= end) return false;
+            group_bits = *cursor++;
+            group_left = 8;
+          }
+          uint64_t delta;
+          if(!binary_trace::get_varint(cursor, end, delta)) return false;
+          time_us += (long long) delta;
+          value = group_bits & 1;
+          group_bits >>= 1;
+          group_left--;
+          return true;
+        }
+
+        void release() {
+          if(data) ::munmap((void*) data, size);
+          data = nullptr;
+        }
+
+        const uint8_t* data;
+        std::size_t size;
+        const uint8_t* cursor;
+        const uint8_t* end;
+        uint64_t remaining;
+        long long time_us;
+        uint8_t group_bits;
+        int group_left;
+};
+
+// Reads the kind of a trace file without decoding it.
+inline bool peek_trace_kind(const std::string& path, trace_kind& kind) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+  uint8_t header[binary_trace::header_size];
+  const bool ok = ::read(fd, header, sizeof(header)) == (ssize_t) sizeof(header)
+                  && std::memcmp(header, binary_trace::magic, 4) == 0 && header[4] <= 1;
+  ::close(fd);
+  if(ok) kind = (trace_kind) header[4];
+  return ok;
+}
+#endif
+
+#endif // SEEED_BOT_BINARY_TRACE_HPP
@@ -0,0 +1,68 @@
+/**
+* ARSLab - Carleton University
+*
+* Cycle Clock:
+* Cheap timestamps for instrumentation. In RT_ARM_MBED it reads the Cortex-M DWT cycle
+* counter (one load, wraps after 2^32 cycles: ~51 s at 84 MHz); on desktop it uses
+* std::chrono::steady_clock. Differences are converted to nanoseconds with to_ns().
+*/
+#ifndef SEEED_BOT_CYCLE_CLOCK_HPP
+#define SEEED_BOT_CYCLE_CLOCK_HPP
+
+#include <cstdint>
+
+#ifdef RT_ARM_MBED
+  #include "mbed.h"
+#else
+  #include <chrono>
+#endif
+
+struct cycle_clock {
+  #ifdef RT_ARM_MBED
+    using ticks = uint32_t;
+
+    // Enables the DWT cycle counter, safe to call more than once.
+    static void init() {
+      if(!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+      }
+    }
+
+    static ticks now() {
+      return DWT->CYCCNT;
+    }
+
+    static uint64_t to_ns(ticks t) {
+      return (uint64_t) t * 1000 / (SystemCoreClock / 1000000);
+    }
+
+    static ticks from_us(long long us) {
+      return (ticks) ((uint64_t) us * (SystemCoreClock / 1000000));
+    }
+  #else
+    using ticks = uint64_t;
+
+    static void init() {}
+
+    static ticks now() {
+      return (ticks) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static uint64_t to_ns(ticks t) {
+      return t;
+    }
+
+    static ticks from_us(long long us) {
+      return (ticks) us * 1000;
+    }
+  #endif
+
+  // Unsigned difference, correct across one counter wrap.
+  static ticks elapsed(ticks start, ticks end) {
+    return end - start;
+  }
+};
+
+#endif // SEEED_BOT_CYCLE_CLOCK_HPP
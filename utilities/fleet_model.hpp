@@ -0,0 +1,108 @@
+/**
+* ARSLab - Carleton University
+*
+* Fleet Model:
+* Builds a TOP model with N robots, N set at run time, instead of wiring one lightBot and its
+* I/O by hand. A robot builder adds the models of robot i (named with the index, e.g.
+* "lightBot7") and their couplings; make_fleet_model calls it for every robot of a range and
+* puts the result in one flat coupled model.
+*
+* The robots of a fleet exchange no messages, so fleet_runner splits them into partitions,
+* each a TOP model with its own Cadmium runner, and runs the partitions on their own threads.
+* Each runner handles the simultaneous events of its robots only; the result is the same as
+* one runner over the whole fleet.
+*
+*   fleet_runner<TIME> fleet(10000, 8, [&](fleet_parts& parts, std::size_t i) { ... });
+*   fleet.run_until(TIME("00:00:10:000"));
+*/
+#ifndef SEEED_BOT_FLEET_MODEL_HPP
+#define SEEED_BOT_FLEET_MODEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cadmium/modeling/coupling.hpp>
+#include <cadmium/modeling/dynamic_coupled.hpp>
+#include <cadmium/engine/pdevs_dynamic_runner.hpp>
+#include <cadmium/logger/common_loggers.hpp>
+
+// Models and couplings of the robots added so far.
+struct fleet_parts {
+  cadmium::dynamic::modeling::Models models;
+  cadmium::dynamic::modeling::ICs ics;
+};
+
+// Adds the models of robot i and their couplings.
+using fleet_robot_builder = std::function<void(fleet_parts&, std::size_t)>;
+
+// Model name of robot i: name followed by the index.
+inline std::string fleet_name(const char* name, std::size_t i) {
+  return std::string(name) + std::to_string(i);
+}
+
+// Robots first .. first + count - 1 in one coupled model.
+template<typename TIME>
+std::shared_ptr<cadmium::dynamic::modeling::coupled<TIME>> make_fleet_model(const std::string& name, std::size_t first, std::size_t count,
+                                                                            const fleet_robot_builder& robot) {
+  fleet_parts parts;
+  for(std::size_t i = first; i < first + count; i++) {
+    robot(parts, i);
+  }
+  cadmium::dynamic::modeling::Ports iports = {};
+  cadmium::dynamic::modeling::Ports oports = {};
+  cadmium::dynamic::modeling::EICs eics = {};
+  cadmium::dynamic::modeling::EOCs eocs = {};
+  return std::make_shared<cadmium::dynamic::modeling::coupled<TIME>>(name, parts.models, iports, oports, eics, eocs, parts.ics);
+}
+
+template<typename TIME, typename LOGGER = cadmium::logger::not_logger>
+class fleet_runner {
+    public:
+        // Builds the models of all robots, spread evenly over partitions runners.
+        fleet_runner(std::size_t robots, unsigned partitions, const fleet_robot_builder& robot) {
+          const std::size_t parts = std::max<std::size_t>(1, std::min<std::size_t>(partitions, robots));
+          for(std::size_t p = 0; p < parts; p++) {
+            const std::size_t first = robots * p / parts;
+            const std::size_t count = robots * (p + 1) / parts - first;
+            auto top = make_fleet_model<TIME>(fleet_name("TOP", p), first, count, robot);
+            runners.push_back(std::make_shared<cadmium::dynamic::engine::runner<TIME, LOGGER>>(top, TIME()));
+          }
+        }
+
+        std::size_t partitions() const { return runners.size(); }
+
+        // Runs every partition until t, one thread each. The first exception thrown by a
+        // partition is rethrown once all of them have stopped.
+        void run_until(const TIME& t) {
+          if(runners.size() == 1) {
+            runners[0]->run_until(t);
+            return;
+          }
+          std::vector<std::exception_ptr> errors(runners.size());
+          std::vector<std::thread> threads;
+          for(std::size_t p = 0; p < runners.size(); p++) {
+            threads.emplace_back([this, p, &t, &errors]() {
+              try {
+                runners[p]->run_until(t);
+              } catch(...) {
+                errors[p] = std::current_exception();
+              }
+            });
+          }
+          for(std::thread& thread : threads) thread.join();
+          for(const std::exception_ptr& error : errors) {
+            if(error) std::rethrow_exception(error);
+          }
+        }
+
+    private:
+        std::vector<std::shared_ptr<cadmium::dynamic::engine::runner<TIME, LOGGER>>> runners;
+};
+
+#endif // SEEED_BOT_FLEET_MODEL_HPP
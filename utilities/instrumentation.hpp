@@ -0,0 +1,78 @@
+/**
+* ARSLab - Carleton University
+*
+* Instrumentation:
+* Settings of the decorators that measure a model, given once for the whole stack of them
+* (atomics/deadlineMonitor.hpp, filteredInput.hpp, telemetryTap.hpp, latencyProbe.hpp, modelProfiler.hpp).
+*
+*   const instrumentation lightPairConfig = {"lightPair", sensorDeadline, lightFilter, telemetry_pin::A4};
+*   make_dynamic_atomic_model<profiled<latency_source<filtered_input<DualAnalogInput>::model>::model>::model, TIME>(lightPairConfig.name, lightPairConfig, A4, A5);
+*
+* Every decorator takes the instrumentation ahead of the arguments of the model it wraps and
+* hands it on if that model is a decorator too (decorator_base), so the arguments are the same
+* whatever the decorators and their nesting order. Each one uses the fields it needs; the name
+* keys the counters of the model in every report.
+*/
+#ifndef SEEED_BOT_INSTRUMENTATION_HPP
+#define SEEED_BOT_INSTRUMENTATION_HPP
+
+#include <type_traits>
+#include <utility>
+
+#include "telemetry.hpp"
+
+// Light sensor filter (filtered_input).
+struct input_filter {
+  float deadband;
+  unsigned decimation;
+  long long period_us;
+};
+
+// Pass-through settings: every sample is sent.
+constexpr input_filter no_input_filter = {0, 1, 0};
+
+// Real-time budget of a model (deadline_monitor).
+struct deadline_policy {
+  long long budget_us; // a transition later than this is an overrun
+  bool coalesce;       // drop stale samples (input models only)
+};
+
+struct instrumentation {
+  const char* name;                         // model id, must outlive the model (a string literal)
+  deadline_policy deadline = {0, false};    // deadline_monitor
+  input_filter filter = no_input_filter;    // filtered_input
+  telemetry_pin pin = telemetry_pin::A2;    // telemetry_source, telemetry_sink (A4 for a light_pair)
+};
+
+// True for the decorators and the models they wrap: they take an instrumentation first.
+template<typename M, typename = void>
+struct is_instrumented : std::false_type {};
+
+template<typename M>
+struct is_instrumented<M, std::void_t<typename M::instrumented_model>> : std::true_type {};
+
+// Base of the decorators: constructs the wrapped model with the instrumentation if it is a
+// decorator too, otherwise with the remaining arguments only.
+template<typename BASE, bool = is_instrumented<BASE>::value>
+class decorator_base : public BASE {
+    public:
+        using instrumented_model = void;
+
+        decorator_base() : BASE() {}
+
+        template<typename... ARGs>
+        decorator_base(const instrumentation& config, ARGs&&... args) : BASE(config, std::forward<ARGs>(args)...) {}
+};
+
+template<typename BASE>
+class decorator_base<BASE, false> : public BASE {
+    public:
+        using instrumented_model = void;
+
+        decorator_base() : BASE() {}
+
+        template<typename... ARGs>
+        decorator_base([[maybe_unused]] const instrumentation& config, ARGs&&... args) : BASE(std::forward<ARGs>(args)...) {}
+};
+
+#endif // SEEED_BOT_INSTRUMENTATION_HPP
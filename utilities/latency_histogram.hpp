@@ -0,0 +1,89 @@
+/**
+* ARSLab - Carleton University
+*
+* Latency Histogram:
+* Fixed-size log-linear histogram of nanosecond values (8 sub-buckets per power of two,
+* so percentiles are within 12.5%). Values above 2^40 ns (~18 min) share the last bucket.
+* Recording is a few integer operations and never allocates. min and max are exact.
+*/
+#ifndef SEEED_BOT_LATENCY_HISTOGRAM_HPP
+#define SEEED_BOT_LATENCY_HISTOGRAM_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+class LatencyHistogram {
+    public:
+        static constexpr int SUB_BUCKET_BITS = 3;
+        static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static constexpr int MAX_BITS = 40;
+        static constexpr int BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        LatencyHistogram() noexcept {
+          reset();
+        }
+
+        void reset() {
+          for(int i = 0; i < BUCKETS; i++) counts[i] = 0;
+          total = 0;
+          minimum = UINT64_MAX;
+          maximum = 0;
+        }
+
+        void record(uint64_t ns) {
+          counts[bucket(ns)]++;
+          total++;
+          if(ns < minimum) minimum = ns;
+          if(ns > maximum) maximum = ns;
+        }
+
+        uint32_t count() const { return total; }
+        uint64_t min() const { return total ? minimum : 0; }
+        uint64_t max() const { return maximum; }
+
+        // Upper bound of the bucket holding the p-th percentile (0 < p <= 100), clamped to max().
+        uint64_t percentile(double p) const {
+          if(total == 0) return 0;
+          uint64_t rank = (uint64_t) (p / 100.0 * total + 0.5);
+          if(rank < 1) rank = 1;
+          uint64_t seen = 0;
+          for(int i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if(seen >= rank) {
+              const uint64_t upper = upper_bound(i);
+              return upper < maximum ? upper : maximum;
+            }
+          }
+          return maximum;
+        }
+
+        // One line: "<name>: n=... min=... p50=... p99=... max=... us"
+        void print(FILE* out, const char* name) const {
+          fprintf(out, "%s: n=%lu min=%.3f p50=%.3f p99=%.3f max=%.3f us\n", name, (unsigned long) total,
+                  min() / 1000.0, percentile(50) / 1000.0, percentile(99) / 1000.0, max() / 1000.0);
+        }
+
+    private:
+        static int bucket(uint64_t v) {
+          if(v < (uint64_t) SUB_BUCKETS) return (int) v;
+          if(v >> MAX_BITS) return BUCKETS - 1;
+          int msb = MAX_BITS - 1;
+          while(!(v >> msb)) msb--;
+          const int shift = msb - SUB_BUCKET_BITS;
+          return (shift + 1) * SUB_BUCKETS + (int) ((v >> shift) & (SUB_BUCKETS - 1));
+        }
+
+        static uint64_t upper_bound(int index) {
+          if(index < SUB_BUCKETS) return (uint64_t) index;
+          const int shift = index / SUB_BUCKETS - 1;
+          const uint64_t base = (uint64_t) (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+          return base + ((uint64_t) 1 << shift) - 1;
+        }
+
+        uint32_t counts[BUCKETS];
+        uint32_t total;
+        uint64_t minimum;
+        uint64_t maximum;
+};
+
+#endif // SEEED_BOT_LATENCY_HISTOGRAM_HPP
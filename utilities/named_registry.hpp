@@ -0,0 +1,57 @@
+/**
+* ARSLab - Carleton University
+*
+* Named Registry:
+* Fixed table of per-model counters looked up by model name, for the instrumentation decorators
+* (profiles, latency histograms, filter and deadline counters). An entry is created on the
+* first lookup of its name and kept in registration order; nothing is ever allocated, and a
+* lookup past the last slot returns nullptr so the model simply goes unmeasured.
+*
+*   static NamedRegistry<model_profile, 12>& registry();
+*   model_profile* profile = registry().get("lightBot");
+*   registry().for_each([](const char* name, model_profile& p) { ... });
+*
+* Names are compared by content but not copied: they must outlive the registry (string literals).
+*/
+#ifndef SEEED_BOT_NAMED_REGISTRY_HPP
+#define SEEED_BOT_NAMED_REGISTRY_HPP
+
+#include <cstddef>
+#include <cstring>
+
+template<typename T, std::size_t SLOTS>
+class NamedRegistry {
+    public:
+        NamedRegistry() : used(0) {}
+
+        // Entry registered under name, created on first use. nullptr when all slots are taken.
+        T* get(const char* name) {
+          for(std::size_t i = 0; i < used; i++) {
+            if(std::strcmp(names[i], name) == 0) return &entries[i];
+          }
+          if(used == SLOTS) return nullptr;
+          names[used] = name;
+          return &entries[used++];
+        }
+
+        // Calls visit(name, entry) for every entry, in registration order.
+        template<typename VISIT>
+        void for_each(VISIT visit) {
+          for(std::size_t i = 0; i < used; i++) visit(names[i], entries[i]);
+        }
+
+        template<typename VISIT>
+        void for_each(VISIT visit) const {
+          for(std::size_t i = 0; i < used; i++) visit(names[i], entries[i]);
+        }
+
+        std::size_t size() const { return used; }
+        static constexpr std::size_t capacity() { return SLOTS; }
+
+    private:
+        const char* names[SLOTS];
+        T entries[SLOTS];
+        std::size_t used;
+};
+
+#endif // SEEED_BOT_NAMED_REGISTRY_HPP
@@ -0,0 +1,61 @@
+/**
+* ARSLab - Carleton University
+*
+* Ring Buffer:
+* Lock-free single-producer/single-consumer queue of fixed-size elements.
+* The producer (the simulation thread) never blocks: push() fails when the buffer is full
+* and the caller decides what to do with the element.
+*/
+#ifndef SEEED_BOT_RING_BUFFER_HPP
+#define SEEED_BOT_RING_BUFFER_HPP
+
+#include <atomic>
+#include <cstddef>
+
+template<typename T, std::size_t SIZE>
+class RingBuffer {
+    static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "RingBuffer size must be a power of two");
+
+    public:
+        RingBuffer() noexcept : head(0), tail(0) {}
+
+        // Producer side. Returns false when the buffer is full.
+        bool push(const T& item) {
+          const std::size_t h = head.load(std::memory_order_relaxed);
+          if(h - tail.load(std::memory_order_acquire) == SIZE) {
+            return false;
+          }
+          items[h & (SIZE - 1)] = item;
+          head.store(h + 1, std::memory_order_release);
+          return true;
+        }
+
+        // Consumer side. Returns false when the buffer is empty.
+        bool pop(T& item) {
+          const std::size_t t = tail.load(std::memory_order_relaxed);
+          if(t == head.load(std::memory_order_acquire)) {
+            return false;
+          }
+          item = items[t & (SIZE - 1)];
+          tail.store(t + 1, std::memory_order_release);
+          return true;
+        }
+
+        // Elements queued. Exact on the producer side, where it can only shrink behind its back.
+        std::size_t size() const {
+          return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire);
+        }
+
+        bool empty() const {
+          return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+        }
+
+        static constexpr std::size_t capacity() { return SIZE; }
+
+    private:
+        T items[SIZE];
+        std::atomic<std::size_t> head;
+        std::atomic<std::size_t> tail;
+};
+
+#endif // SEEED_BOT_RING_BUFFER_HPP
@@ -0,0 +1,332 @@
+/**
+* ARSLab - Carleton University
+*
+* Ring Logger:
+* Non-blocking sink for the Cadmium loggers. Formatted log text is collected a line at a time,
+* cut into fixed-size records and pushed into a lock-free ring buffer, which is drained to the
+* real output off the control loop: by a low-priority thread writing the log file on desktop,
+* and by the serial TX-empty interrupt in RT_ARM_MBED (the build has no RTOS threads).
+* A line is queued whole or not at all: when the ring buffer does not have room for all of its
+* records it is dropped and counted in overflows() instead of stalling the control loop, so the
+* sink never gets part of a line. Lines longer than RING_LOG_LINE_SIZE are cut and end in "...".
+* flush() queues the text collected so far as it is (telemetry frames use this).
+*
+* Only the writing is taken off the control loop, not the formatting. A Cadmium logger formats
+* each entry with cadmium::dynamic::logger::formatter (an ostringstream over the typed message
+* bags and the model state) before it hands the text to the sink, and a sink provider only gets
+* an std::ostream, so the records hold text and not raw events. Formatting in the drain would
+* mean replacing Cadmium's formatters with a logger that copies every message type and state
+* type into the ring, which the logger API does not offer. Build with NO_LOGS (not_logger)
+* when the formatting cost matters.
+*
+* In RT_ARM_MBED the drain owns the stdio UART, so main.cpp sends stdout through the ring as well
+* (RingConsole) and nothing else writes to the port while the drain runs. After the run,
+* set_wait(true) makes full buffers wait for the drain instead of dropping, for the reports.
+*
+* Usage:
+*   RingLogDrain drain(ring_log_buffer(), out_data);      // desktop
+*   RingLogDrain drain(ring_log_buffer(), USBTX, USBRX);  // RT_ARM_MBED
+*   drain.start();
+*   cadmium::logger::logger<..., ring_sink_provider> ...
+*   drain.stop(); // flushes what is left in the buffer
+*/
+#ifndef SEEED_BOT_RING_LOGGER_HPP
+#define SEEED_BOT_RING_LOGGER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+
+#ifdef RT_ARM_MBED
+  #include "mbed.h"
+  #ifndef MBED_CONF_PLATFORM_STDIO_BAUD_RATE
+    #define MBED_CONF_PLATFORM_STDIO_BAUD_RATE 115200
+  #endif
+#else
+  #include <chrono>
+  #include <thread>
+  #ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+  #endif
+#endif
+
+#include "ring_buffer.hpp"
+
+#ifndef RING_LOG_RECORD_SIZE
+  #define RING_LOG_RECORD_SIZE 64
+#endif
+
+#ifndef RING_LOG_LINE_SIZE
+  #ifdef RT_ARM_MBED
+    #define RING_LOG_LINE_SIZE 256
+  #else
+    #define RING_LOG_LINE_SIZE 4096
+  #endif
+#endif
+
+#ifndef RING_LOG_RECORDS
+  #ifdef RT_ARM_MBED
+    #define RING_LOG_RECORDS 128
+  #else
+    #define RING_LOG_RECORDS 16384
+  #endif
+#endif
+
+// A fixed-size piece of log text. A log line longer than a record spans several records.
+struct log_record {
+  unsigned char length;
+  char text[RING_LOG_RECORD_SIZE - 1];
+};
+
+class RingLogBuffer : public std::streambuf {
+    public:
+        using ring_type = RingBuffer<log_record, RING_LOG_RECORDS>;
+
+        RingLogBuffer() noexcept : length(0), truncating(false), waiting(false), dropped(0), on_commit(nullptr), on_commit_context(nullptr) {}
+
+        ring_type& records() { return ring; }
+
+        // Called after each line is queued, lets an interrupt-driven drain wake up.
+        void set_commit_hook(void (*hook)(void*), void* context) {
+          on_commit_context = context;
+          on_commit = hook;
+        }
+
+        // When set, a line that does not fit waits for the drain instead of being dropped.
+        // Only for output outside the control loop, while a drain is running.
+        void set_wait(bool wait) { waiting = wait; }
+
+        // Number of log lines lost because the ring buffer was full.
+        unsigned long overflows() const { return dropped.load(std::memory_order_relaxed); }
+
+    protected:
+        int_type overflow(int_type c) override {
+          if(traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+          }
+          append(traits_type::to_char_type(c));
+          return c;
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override {
+          for(std::streamsize i = 0; i < n; i++) {
+            append(s[i]);
+          }
+          return n;
+        }
+
+        int sync() override {
+          commit();
+          return 0;
+        }
+
+    private:
+        static constexpr std::size_t record_text = sizeof(log_record::text);
+
+        void append(char c) {
+          // The rest of a line that was cut is skipped up to its end.
+          if(truncating) {
+            if(c == '\n') truncating = false;
+            return;
+          }
+          line[length++] = c;
+          if(c == '\n') {
+            commit();
+          } else if(length == sizeof(line) - 4) {
+            std::memcpy(line + length, "...\n", 4);
+            length += 4;
+            commit();
+            truncating = true;
+          }
+        }
+
+        // Queues the collected text if the ring buffer has room for all of it.
+        void commit() {
+          if(length == 0) return;
+          const std::size_t needed = (length + record_text - 1) / record_text;
+          while(ring_type::capacity() - ring.size() < needed) {
+            if(!waiting || needed > ring_type::capacity()) {
+              dropped.fetch_add(1, std::memory_order_relaxed);
+              length = 0;
+              return;
+            }
+            #ifndef RT_ARM_MBED
+              std::this_thread::yield();
+            #endif
+          }
+          log_record record;
+          for(std::size_t start = 0; start < length; start += record_text) {
+            record.length = (unsigned char) (length - start < record_text ? length - start : record_text);
+            std::memcpy(record.text, line + start, record.length);
+            ring.push(record);
+          }
+          length = 0;
+          if(on_commit) on_commit(on_commit_context);
+        }
+
+        ring_type ring;
+        char line[RING_LOG_LINE_SIZE];
+        std::size_t length;
+        bool truncating;
+        volatile bool waiting;
+        std::atomic<unsigned long> dropped;
+        void (*on_commit)(void*);
+        void* on_commit_context;
+};
+
+#ifdef RT_ARM_MBED
+// Sends the records over a serial port one character per TX-empty interrupt.
+// The interrupt is only enabled while there is something to send.
+class RingLogDrain {
+    public:
+        RingLogDrain(RingLogBuffer& src, PinName tx, PinName rx, int baud = MBED_CONF_PLATFORM_STDIO_BAUD_RATE)
+          : source(src), serial(tx, rx, baud), running(false), sending(false) {
+          record.length = 0;
+          position = 0;
+        }
+
+        ~RingLogDrain() {
+          stop();
+        }
+
+        void start() {
+          if(running.exchange(true)) return;
+          source.set_commit_hook(&RingLogDrain::wake, this);
+          wake(this);
+        }
+
+        // Disables the interrupt and writes out everything still in the buffer.
+        void stop() {
+          if(!running.exchange(false)) return;
+          source.pubsync();
+          source.set_commit_hook(nullptr, nullptr);
+          serial.attach(nullptr, mbed::SerialBase::TxIrq);
+          sending = false;
+          while(position < record.length) serial.putc(record.text[position++]);
+          while(source.records().pop(record)) {
+            for(position = 0; position < record.length; position++) serial.putc(record.text[position]);
+          }
+        }
+
+    private:
+        static void wake(void* self) {
+          RingLogDrain* drain = static_cast<RingLogDrain*>(self);
+          if(!drain->sending.exchange(true)) {
+            drain->serial.attach(mbed::callback(drain, &RingLogDrain::on_tx_empty), mbed::SerialBase::TxIrq);
+          }
+        }
+
+        // Interrupt context: the only consumer of the ring buffer while running.
+        void on_tx_empty() {
+          while(serial.writeable()) {
+            if(position == record.length) {
+              if(!source.records().pop(record)) {
+                sending = false;
+                serial.attach(nullptr, mbed::SerialBase::TxIrq);
+                // A record committed while going idle would otherwise wait for the next commit.
+                if(!source.records().empty()) wake(this);
+                return;
+              }
+              position = 0;
+            }
+            serial.putc(record.text[position++]);
+          }
+        }
+
+        RingLogBuffer& source;
+        mbed::RawSerial serial;
+        std::atomic<bool> running;
+        std::atomic<bool> sending;
+        log_record record;
+        unsigned char position;
+};
+#else
+// Moves records from the ring buffer to the sink from a low-priority thread.
+class RingLogDrain {
+    public:
+        RingLogDrain(RingLogBuffer& src, std::ostream& dst) noexcept
+          : source(src), sink(dst), running(false) {}
+
+        ~RingLogDrain() {
+          stop();
+        }
+
+        void start() {
+          if(running.exchange(true)) return;
+          thread = std::thread(&RingLogDrain::run, this);
+          #ifdef __linux__
+            sched_param param = {};
+            pthread_setschedparam(thread.native_handle(), SCHED_BATCH, &param);
+          #endif
+        }
+
+        // Stops the drain thread and writes out everything still in the buffer.
+        void stop() {
+          if(!running.exchange(false)) return;
+          source.pubsync();
+          thread.join();
+          drain();
+          sink.flush();
+        }
+
+        // Writes every record currently in the buffer, returns how many there were.
+        std::size_t drain() {
+          log_record record;
+          std::size_t count = 0;
+          while(source.records().pop(record)) {
+            sink.write(record.text, record.length);
+            count++;
+          }
+          return count;
+        }
+
+    private:
+        void run() {
+          while(running.load(std::memory_order_relaxed)) {
+            if(drain() == 0) {
+              std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+          }
+        }
+
+        RingLogBuffer& source;
+        std::ostream& sink;
+        std::atomic<bool> running;
+        std::thread thread;
+};
+#endif
+
+inline RingLogBuffer& ring_log_buffer() {
+  static RingLogBuffer buffer;
+  return buffer;
+}
+
+// Sink provider for cadmium::logger::logger.
+struct ring_sink_provider{
+  static std::ostream& sink(){
+    static std::ostream os(&ring_log_buffer());
+    return os;
+  }
+};
+
+#ifdef RT_ARM_MBED
+// stdout/stderr through the ring buffer, so the drain is the only writer of the stdio UART.
+// Installed by returning it from mbed::mbed_override_console() (see main.cpp).
+class RingConsole : public mbed::FileHandle {
+    public:
+        ssize_t write(const void* buffer, size_t size) override {
+          ring_log_buffer().sputn((const char*) buffer, (std::streamsize) size);
+          return (ssize_t) size;
+        }
+
+        ssize_t read(void*, size_t) override { return -EAGAIN; }
+        off_t seek(off_t, int) override { return -ESPIPE; }
+        int close() override { return 0; }
+        int isatty() override { return 1; }
+};
+#endif
+
+#endif // SEEED_BOT_RING_LOGGER_HPP
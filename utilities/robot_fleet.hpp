@@ -0,0 +1,162 @@
+/**
+* ARSLab - Carleton University
+*
+* Robot Fleet:
+* Plant for closed-loop simulation: differential-drive Seeed Bots in a round arena lit by one
+* light source. It takes the four motor pin values of each robot and produces what its
+* sensors read: the left/right light sensors (A4/A5) and the center IR (A2, 1 while the
+* robot is over the arena floor).
+*
+* The robots are stored as a structure of arrays and step() updates all of them in straight
+* loops without branches, so the compiler can vectorize them (-O3; the sin/cos also need
+* -ffast-math with glibc). The sin/cos of each heading are computed once per step and kept,
+* for the next motion and for the sensor directions.
+*
+* Motors: each wheel is an H-bridge driven by a PWM pin (motor1) and a direction pin (motor2);
+* the wheel turns forward at (motor2 - motor1) of max_speed, which is how the LightBot motor
+* table drives (straight = {0, 1, 0, 1}).
+*/
+#ifndef SEEED_BOT_ROBOT_FLEET_HPP
+#define SEEED_BOT_ROBOT_FLEET_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+struct plant_params {
+  float max_speed;    // wheel speed at full drive (m/s)
+  float wheel_base;   // distance between the wheels (m)
+  float arena_radius; // the floor is a disc around (0, 0), the center IR sees nothing beyond (m)
+  float light_x;      // light source position (m)
+  float light_y;
+  float light_range;  // distance at which the light reading is halved (m)
+  float sensor_angle; // left sensor points sensor_angle left of the heading, right one right (rad)
+  float ambient;      // reading of a sensor facing away from the light
+};
+
+constexpr plant_params default_plant = {0.2f, 0.1f, 2.0f, 0.0f, 0.0f, 0.5f, 0.5236f, 0.1f};
+
+class robot_fleet {
+    public:
+        explicit robot_fleet(std::size_t robots, const plant_params& params = default_plant)
+          : x(robots, 0), y(robots, 0), heading(robots, 0), cos_heading(robots, 1), sin_heading(robots, 0), right_drive(robots, 0), left_drive(robots, 0),
+            left_light(robots, 0), right_light(robots, 0), ground(robots, 1), p(params) {
+          sense();
+        }
+
+        std::size_t size() const { return x.size(); }
+        const plant_params& params() const { return p; }
+
+        // Random poses within the inner half of the arena.
+        void scatter(uint64_t seed) {
+          std::mt19937_64 rng(seed);
+          std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+          for(std::size_t i = 0; i < size(); i++) {
+            const float r = 0.5f * p.arena_radius * std::sqrt(unit(rng));
+            const float a = 6.2831853f * unit(rng);
+            x[i] = r * std::cos(a);
+            y[i] = r * std::sin(a);
+            heading[i] = 6.2831853f * unit(rng);
+            cos_heading[i] = std::cos(heading[i]);
+            sin_heading[i] = std::sin(heading[i]);
+          }
+          sense();
+        }
+
+        void set_pose(std::size_t i, float px, float py, float theta) {
+          x[i] = px;
+          y[i] = py;
+          heading[i] = theta;
+          cos_heading[i] = std::cos(theta);
+          sin_heading[i] = std::sin(theta);
+        }
+
+        // Motor pin values of robot i, as sent on the LightBot motor ports.
+        void set_motors(std::size_t i, float rightMotor1, bool rightMotor2, float leftMotor1, bool leftMotor2) {
+          right_drive[i] = (rightMotor2 ? 1.0f : 0.0f) - rightMotor1;
+          left_drive[i] = (leftMotor2 ? 1.0f : 0.0f) - leftMotor1;
+        }
+
+        // Moves every robot dt seconds with its current drive, then updates the sensors.
+        void step(float dt) {
+          const std::size_t n = size();
+          float* __restrict px = x.data();
+          float* __restrict py = y.data();
+          float* __restrict th = heading.data();
+          float* __restrict ch = cos_heading.data();
+          float* __restrict sh = sin_heading.data();
+          const float* __restrict vr = right_drive.data();
+          const float* __restrict vl = left_drive.data();
+          const float linear = 0.5f * p.max_speed * dt;
+          const float angular = p.max_speed * dt / p.wheel_base;
+          for(std::size_t i = 0; i < n; i++) {
+            const float v = linear * (vr[i] + vl[i]);
+            px[i] += v * ch[i];
+            py[i] += v * sh[i];
+            th[i] += angular * (vr[i] - vl[i]);
+          }
+          for(std::size_t i = 0; i < n; i++) {
+            ch[i] = std::cos(th[i]);
+            sh[i] = std::sin(th[i]);
+          }
+          sense();
+        }
+
+        // Sensor readings for the current poses.
+        void sense() {
+          const std::size_t n = size();
+          const float* __restrict px = x.data();
+          const float* __restrict py = y.data();
+          const float* __restrict ch = cos_heading.data();
+          const float* __restrict sh = sin_heading.data();
+          float* __restrict ll = left_light.data();
+          float* __restrict rl = right_light.data();
+          uint8_t* __restrict g = ground.data();
+          const float ca = std::cos(p.sensor_angle);
+          const float sa = std::sin(p.sensor_angle);
+          const float inv_range2 = 1.0f / (p.light_range * p.light_range);
+          const float arena2 = p.arena_radius * p.arena_radius;
+          const float lx = p.light_x;
+          const float ly = p.light_y;
+          const float ambient = p.ambient;
+          const float gain = 1.0f - ambient;
+          for(std::size_t i = 0; i < n; i++) {
+            const float c = ch[i];
+            const float s = sh[i];
+            const float dx = lx - px[i];
+            const float dy = ly - py[i];
+            const float d2 = dx * dx + dy * dy;
+            const float falloff = gain / (1.0f + d2 * inv_range2);
+            const float inv_d = 1.0f / std::sqrt(d2 + 1e-6f);
+            // Cosine between each sensor direction and the light, 0 when facing away.
+            const float left_cos = ((c * ca - s * sa) * dx + (s * ca + c * sa) * dy) * inv_d;
+            const float right_cos = ((c * ca + s * sa) * dx + (s * ca - c * sa) * dy) * inv_d;
+            ll[i] = ambient + falloff * std::max(left_cos, 0.0f);
+            rl[i] = ambient + falloff * std::max(right_cos, 0.0f);
+          }
+          for(std::size_t i = 0; i < n; i++) {
+            g[i] = (px[i] * px[i] + py[i] * py[i]) < arena2;
+          }
+        }
+
+        // Robot state, one array per field.
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> heading;
+        std::vector<float> cos_heading; // kept with heading, for the motion and the sensors
+        std::vector<float> sin_heading;
+        std::vector<float> right_drive; // wheel drive in [-1, 1]
+        std::vector<float> left_drive;
+        // Sensor readings.
+        std::vector<float> left_light;
+        std::vector<float> right_light;
+        std::vector<uint8_t> ground;    // center IR pin: 1 over the floor
+
+    private:
+        plant_params p;
+};
+
+#endif // SEEED_BOT_ROBOT_FLEET_HPP
@@ -0,0 +1,252 @@
+/**
+* ARSLab - Carleton University
+*
+* Telemetry:
+* Compact stream of pin changes for field runs, small enough for the 115200 baud stdio:
+* one bit-packed record per pin change, with the time as a delta from the previous record.
+* The decoder (telemetry_decode.cpp) rebuilds the inputs/ and outputs/ text files from it.
+*
+* Records are grouped in frames, so a decoder can join the stream anywhere and skip
+* corrupted or dropped bytes:
+*   frame    0xA5 0x5A | payload length (u8) | payload | checksum (u8, sum of length and payload)
+*   payload  varint(frame start time in microseconds) | records
+*   record   u8: pin (bits 0-2) | level (bit 3, digital pins) | time delta bits 0-2 (bits 4-6)
+*                | more delta follows (bit 7)
+*            varint(time delta >> 3), only when bit 7 is set
+*            u16 value * 65535, little endian, analog pins only
+*
+* A digital change within 8 us of the previous record is one byte, a PWM or light sample
+* three bytes plus the delta. Frames are written to an std::ostream (the log ring buffer in
+* main.cpp, drained off the control loop) when full or 250 ms after they were started.
+*/
+#ifndef SEEED_BOT_TELEMETRY_HPP
+#define SEEED_BOT_TELEMETRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+
+enum class telemetry_pin : uint8_t {A2 = 0, A4 = 1, A5 = 2, D8 = 3, D11 = 4, D12 = 5, D13 = 6};
+
+namespace telemetry {
+  constexpr uint8_t sync0 = 0xA5;
+  constexpr uint8_t sync1 = 0x5A;
+  constexpr std::size_t max_payload = 64;
+  constexpr long long max_frame_us = 250000;
+  constexpr int pins = 7;
+
+  // A2 (center IR) and the motor direction pins D8/D12 carry levels, the others a value in [0, 1].
+  inline bool is_digital(telemetry_pin pin) {
+    return pin == telemetry_pin::A2 || pin == telemetry_pin::D8 || pin == telemetry_pin::D12;
+  }
+
+  // Trace file of each pin, as in top_model/inputs and top_model/outputs.
+  inline const char* file_name(telemetry_pin pin) {
+    static const char* const names[pins] = {
+      "inputs/A2_CenterIR_In.txt", "inputs/A4_leftLightSens_In.txt", "inputs/A5_rightLightSens_In.txt",
+      "outputs/D8_RightMotor1_Out.txt", "outputs/D11_RightMotor2_Out.txt", "outputs/D12_LeftMotor1_Out.txt",
+      "outputs/D13_LeftMotor2_Out.txt"
+    };
+    return names[(int) pin];
+  }
+
+  inline std::size_t put_varint(uint8_t* p, uint64_t v) {
+    std::size_t n = 0;
+    while(v >= 0x80) {
+      p[n++] = (uint8_t) ((v & 0x7F) | 0x80);
+      v >>= 7;
+    }
+    p[n++] = (uint8_t) v;
+    return n;
+  }
+
+  inline bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for(int shift = 0; p < end && shift < 64; shift += 7) {
+      const uint8_t b = *p++;
+      v |= (uint64_t) (b & 0x7F) << shift;
+      if(!(b & 0x80)) return true;
+    }
+    return false;
+  }
+
+  inline uint16_t quantize(float value) {
+    if(!(value > 0)) return 0;
+    if(value >= 1) return 65535;
+    return (uint16_t) (value * 65535.0f + 0.5f);
+  }
+}
+
+class TelemetryEncoder {
+    public:
+        TelemetryEncoder() noexcept : out(nullptr), size(0), start_us(0), last_us(0), frames(0), records(0) {}
+
+        // Frames go to sink from now on; nullptr turns the encoder off.
+        void open(std::ostream* sink) {
+          flush();
+          out = sink;
+        }
+
+        bool active() const { return out != nullptr; }
+
+        void record(telemetry_pin pin, long long time_us, bool level) {
+          put(pin, time_us, level, 0);
+        }
+
+        void record(telemetry_pin pin, long long time_us, float value) {
+          if(telemetry::is_digital(pin)) {
+            put(pin, time_us, value != 0, 0);
+          } else {
+            put(pin, time_us, false, telemetry::quantize(value));
+          }
+        }
+
+        // Writes the frame being filled, if any.
+        void flush() {
+          if(!out || size == 0) return;
+          uint8_t head[3] = {telemetry::sync0, telemetry::sync1, (uint8_t) size};
+          uint8_t checksum = head[2];
+          for(std::size_t i = 0; i < size; i++) checksum += payload[i];
+          out->write((const char*) head, 3);
+          out->write((const char*) payload, size);
+          out->put((char) checksum);
+          out->flush();
+          frames++;
+          size = 0;
+        }
+
+        unsigned long frame_count() const { return frames; }
+        unsigned long record_count() const { return records; }
+
+    private:
+        void put(telemetry_pin pin, long long time_us, bool level, uint16_t value) {
+          if(!out) return;
+          if(size > 0 && time_us - start_us >= telemetry::max_frame_us) flush();
+          uint8_t r[16];
+          std::size_t n = encode(r, pin, time_us, level, value);
+          if(size > 0 && size + n > telemetry::max_payload) {
+            flush();
+            n = encode(r, pin, time_us, level, value);
+          }
+          if(size == 0) {
+            start_us = time_us;
+            size = telemetry::put_varint(payload, (uint64_t) (time_us > 0 ? time_us : 0));
+          }
+          std::memcpy(payload + size, r, n);
+          size += n;
+          last_us = time_us;
+          records++;
+        }
+
+        // The first record of a frame is at the frame start time, the others are a delta from
+        // the previous record.
+        std::size_t encode(uint8_t* r, telemetry_pin pin, long long time_us, bool level, uint16_t value) const {
+          const uint64_t delta = (size > 0 && time_us > last_us) ? (uint64_t) (time_us - last_us) : 0;
+          r[0] = (uint8_t) ((uint8_t) pin | (level ? 0x08 : 0) | ((delta & 0x07) << 4));
+          std::size_t n = 1;
+          if(delta >> 3) {
+            r[0] |= 0x80;
+            n += telemetry::put_varint(r + 1, delta >> 3);
+          }
+          if(!telemetry::is_digital(pin)) {
+            r[n++] = (uint8_t) (value & 0xFF);
+            r[n++] = (uint8_t) (value >> 8);
+          }
+          return n;
+        }
+
+        std::ostream* out;
+        uint8_t payload[telemetry::max_payload + 16];
+        std::size_t size;
+        long long start_us;
+        long long last_us;
+        unsigned long frames;
+        unsigned long records;
+};
+
+// Encoder shared by the telemetry taps (atomics/telemetryTap.hpp).
+inline TelemetryEncoder& telemetry_stream() {
+  static TelemetryEncoder encoder;
+  return encoder;
+}
+
+// Splits a captured byte stream into frames and records. Bytes outside valid frames (other
+// output on the same serial port, lost or corrupted bytes) are skipped.
+class TelemetryDecoder {
+    public:
+        TelemetryDecoder() noexcept : frames(0), bad_frames(0), records(0) {}
+
+        // Calls on_record(telemetry_pin, time_us, value) for every record, in stream order.
+        template<typename CALLBACK>
+        void decode(const uint8_t* data, std::size_t length, CALLBACK on_record) {
+          std::size_t i = 0;
+          while(i + 4 <= length) {
+            if(data[i] != telemetry::sync0 || data[i + 1] != telemetry::sync1) {
+              i++;
+              continue;
+            }
+            const std::size_t size = data[i + 2];
+            if(size == 0 || size > telemetry::max_payload + 16 || i + 4 + size > length) {
+              i++;
+              continue;
+            }
+            uint8_t checksum = data[i + 2];
+            for(std::size_t k = 0; k < size; k++) checksum += data[i + 3 + k];
+            if(checksum != data[i + 3 + size] || !frame(data + i + 3, size, on_record)) {
+              bad_frames++;
+              i++;
+              continue;
+            }
+            frames++;
+            i += 4 + size;
+          }
+        }
+
+        unsigned long frame_count() const { return frames; }
+        unsigned long bad_frame_count() const { return bad_frames; }
+        unsigned long record_count() const { return records; }
+
+    private:
+        // Decodes into a local list first, so a frame that does not parse reports nothing.
+        template<typename CALLBACK>
+        bool frame(const uint8_t* p, std::size_t size, CALLBACK& on_record) {
+          struct entry { telemetry_pin pin; long long time_us; float value; };
+          entry entries[telemetry::max_payload + 16];
+          std::size_t count = 0;
+          const uint8_t* end = p + size;
+          uint64_t start;
+          if(!telemetry::get_varint(p, end, start)) return false;
+          long long time_us = (long long) start;
+          while(p < end) {
+            const uint8_t head = *p++;
+            const int pin = head & 0x07;
+            if(pin >= telemetry::pins) return false;
+            uint64_t delta = (head >> 4) & 0x07;
+            if(head & 0x80) {
+              uint64_t high;
+              if(!telemetry::get_varint(p, end, high)) return false;
+              delta |= high << 3;
+            }
+            time_us += (long long) delta;
+            float value = (head & 0x08) ? 1.0f : 0.0f;
+            if(!telemetry::is_digital((telemetry_pin) pin)) {
+              if(end - p < 2) return false;
+              value = (p[0] | (p[1] << 8)) / 65535.0f;
+              p += 2;
+            }
+            entries[count++] = {(telemetry_pin) pin, time_us, value};
+          }
+          for(std::size_t k = 0; k < count; k++) {
+            on_record(entries[k].pin, entries[k].time_us, entries[k].value);
+          }
+          records += count;
+          return true;
+        }
+
+        unsigned long frames;
+        unsigned long bad_frames;
+        unsigned long records;
+};
+
+#endif // SEEED_BOT_TELEMETRY_HPP
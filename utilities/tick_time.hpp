@@ -0,0 +1,152 @@
+/**
+* ARSLab - Carleton University
+*
+* Tick Time:
+* Simulation TIME type holding a signed 64-bit count of microseconds. Every operation is
+* integer arithmetic and constexpr, so constants like the zero time advance of the controllers
+* or the run_until limit cost nothing at run time, where NDTime parses a string for each of them.
+* Infinity is the largest count and saturates: inf + t == inf, inf - t == inf, and t - inf is
+* the lowest time (0), as there is no negative infinity.
+*
+* It has the interface of NDTime used by Cadmium and this project, so it can replace it in
+* "using TIME = ...": {h, m, s, ms, us} and "HH:MM:SS:mmm[:uuu]" constructors, the
+* getHours()..getMicroseconds() getters, stream operators and std::numeric_limits.
+*
+*   using namespace tick_time_literals;
+*   constexpr TickTime until = 10_min;
+*/
+#ifndef SEEED_BOT_TICK_TIME_HPP
+#define SEEED_BOT_TICK_TIME_HPP
+
+#include <cstdint>
+#include <initializer_list>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "time_conversion.hpp"
+
+class TickTime {
+    public:
+        using rep = int64_t;
+        static constexpr rep INF = std::numeric_limits<rep>::max();
+
+        constexpr TickTime() noexcept : us(0) {}
+
+        // {hours, minutes, seconds, milliseconds, microseconds}, missing trailing fields are 0.
+        constexpr TickTime(std::initializer_list<long long> fields) noexcept : us(0) {
+          const rep scale[] = {3600000000LL, 60000000LL, 1000000LL, 1000LL, 1LL};
+          int i = 0;
+          for(long long f : fields) {
+            if(i < 5) us += f * scale[i++];
+          }
+        }
+
+        // "HH:MM:SS:mmm[:uuu]", or "inf". Anything else throws std::invalid_argument.
+        TickTime(const char* text) : us(0) {
+          long long parsed;
+          const char* end;
+          if(std::string(text) == "inf") {
+            us = INF;
+          } else if(parse_time_string(text, parsed, &end) && *end == '\0') {
+            us = parsed;
+          } else {
+            throw std::invalid_argument(std::string("TickTime: malformed time \"") + text + "\"");
+          }
+        }
+
+        TickTime(const std::string& text) : TickTime(text.c_str()) {}
+
+        static constexpr TickTime from_microseconds(rep microseconds) noexcept {
+          return TickTime(microseconds, 0);
+        }
+
+        static constexpr TickTime infinity() noexcept {
+          return TickTime(INF, 0);
+        }
+
+        constexpr rep microseconds() const noexcept { return us; }
+        constexpr bool isInf() const noexcept { return us == INF; }
+
+        // NDTime getters, used by Cadmium's real-time clock and to_microseconds().
+        constexpr int getHours() const noexcept { return (int) (us / 3600000000LL); }
+        constexpr int getMinutes() const noexcept { return (int) (us / 60000000LL % 60); }
+        constexpr int getSeconds() const noexcept { return (int) (us / 1000000LL % 60); }
+        constexpr int getMilliseconds() const noexcept { return (int) (us / 1000 % 1000); }
+        constexpr int getMicroseconds() const noexcept { return (int) (us % 1000); }
+        constexpr int getNanoseconds() const noexcept { return 0; }
+        constexpr int getPicoseconds() const noexcept { return 0; }
+        constexpr int getFemtoseconds() const noexcept { return 0; }
+
+        constexpr TickTime operator+(const TickTime& o) const noexcept {
+          // Saturates: a sum past the last finite time (max() + anything) is infinity.
+          if(us == INF || o.us == INF) return TickTime(INF, 0);
+          if(o.us > 0 && us > INF - o.us) return TickTime(INF, 0);
+          return TickTime(us + o.us, 0);
+        }
+
+        constexpr TickTime operator-(const TickTime& o) const noexcept {
+          if(us == INF) return TickTime(INF, 0);
+          if(o.us == INF) return TickTime();
+          return TickTime(us - o.us, 0);
+        }
+
+        constexpr TickTime& operator+=(const TickTime& o) noexcept { return *this = *this + o; }
+        constexpr TickTime& operator-=(const TickTime& o) noexcept { return *this = *this - o; }
+
+        constexpr bool operator==(const TickTime& o) const noexcept { return us == o.us; }
+        constexpr bool operator!=(const TickTime& o) const noexcept { return us != o.us; }
+        constexpr bool operator<(const TickTime& o) const noexcept { return us < o.us; }
+        constexpr bool operator<=(const TickTime& o) const noexcept { return us <= o.us; }
+        constexpr bool operator>(const TickTime& o) const noexcept { return us > o.us; }
+        constexpr bool operator>=(const TickTime& o) const noexcept { return us >= o.us; }
+
+        friend std::ostream& operator<<(std::ostream& os, const TickTime& t) {
+          if(t.isInf()) return os << "inf";
+          return os << format_time_string(t.us);
+        }
+
+        friend std::istream& operator>>(std::istream& is, TickTime& t) {
+          std::string text;
+          if(is >> text) t = TickTime(text);
+          return is;
+        }
+
+    private:
+        constexpr TickTime(rep microseconds, int) noexcept : us(microseconds) {}
+
+        rep us;
+};
+
+namespace std {
+  template<> class numeric_limits<TickTime> {
+      public:
+          static constexpr bool is_specialized = true;
+          static constexpr bool has_infinity = true;
+          static constexpr TickTime infinity() noexcept { return TickTime::infinity(); }
+          static constexpr TickTime max() noexcept { return TickTime::from_microseconds(TickTime::INF - 1); }
+          static constexpr TickTime min() noexcept { return TickTime(); }
+          static constexpr TickTime lowest() noexcept { return TickTime(); }
+  };
+}
+
+inline long long to_microseconds(const TickTime& t) {
+  return t.microseconds();
+}
+
+template<>
+inline TickTime from_microseconds<TickTime>(long long us) {
+  return TickTime::from_microseconds(us);
+}
+
+namespace tick_time_literals {
+  constexpr TickTime operator"" _h(unsigned long long v) { return TickTime::from_microseconds((TickTime::rep) v * 3600000000LL); }
+  constexpr TickTime operator"" _min(unsigned long long v) { return TickTime::from_microseconds((TickTime::rep) v * 60000000LL); }
+  constexpr TickTime operator"" _s(unsigned long long v) { return TickTime::from_microseconds((TickTime::rep) v * 1000000LL); }
+  constexpr TickTime operator"" _ms(unsigned long long v) { return TickTime::from_microseconds((TickTime::rep) v * 1000LL); }
+  constexpr TickTime operator"" _us(unsigned long long v) { return TickTime::from_microseconds((TickTime::rep) v); }
+}
+
+#endif // SEEED_BOT_TICK_TIME_HPP
@@ -0,0 +1,68 @@
+/**
+* ARSLab - Carleton University
+*
+* Time Conversion:
+* Helpers to move between the simulation TIME type, integer microseconds and the
+* "HH:MM:SS:mmm" strings used in the pin input/output files.
+*/
+#ifndef SEEED_BOT_TIME_CONVERSION_HPP
+#define SEEED_BOT_TIME_CONVERSION_HPP
+
+#include <cstdio>
+#include <string>
+
+// Any TIME with hour/minute/second/millisecond/microsecond getters (NDTime).
+template<typename TIME>
+long long to_microseconds(const TIME& t) {
+  return ((((long long) t.getHours() * 60 + t.getMinutes()) * 60 + t.getSeconds()) * 1000
+          + t.getMilliseconds()) * 1000 + t.getMicroseconds();
+}
+
+// Any TIME constructible from {hours, minutes, seconds, milliseconds, microseconds}.
+template<typename TIME>
+TIME from_microseconds(long long us) {
+  const int micro = (int) (us % 1000); us /= 1000;
+  const int milli = (int) (us % 1000); us /= 1000;
+  const int sec = (int) (us % 60); us /= 60;
+  const int min = (int) (us % 60); us /= 60;
+  return TIME({(int) us, min, sec, milli, micro});
+}
+
+// Parses "HH:MM:SS:mmm" with any number of trailing fields (":uuu" for microseconds).
+// Returns false if the string does not start with a time.
+inline bool parse_time_string(const char* text, long long& us, const char** end = nullptr) {
+  static const long long scale[] = {3600000000LL, 60000000LL, 1000000LL, 1000LL, 1LL};
+  long long total = 0;
+  int field = 0;
+  const char* p = text;
+  while(field < 5) {
+    if(*p < '0' || *p > '9') return false;
+    long long value = 0;
+    while(*p >= '0' && *p <= '9') {
+      value = value * 10 + (*p++ - '0');
+    }
+    total += value * scale[field++];
+    if(*p != ':') break;
+    p++;
+  }
+  us = total;
+  if(end) *end = p;
+  return true;
+}
+
+// Formats as "HH:MM:SS:mmm", adding ":uuu" only when the time is not a whole millisecond.
+inline std::string format_time_string(long long us) {
+  char text[32];
+  const long long micro = us % 1000; us /= 1000;
+  const long long milli = us % 1000; us /= 1000;
+  const long long sec = us % 60; us /= 60;
+  const long long min = us % 60; us /= 60;
+  if(micro) {
+    std::snprintf(text, sizeof(text), "%02lld:%02lld:%02lld:%03lld:%03lld", us, min, sec, milli, micro);
+  } else {
+    std::snprintf(text, sizeof(text), "%02lld:%02lld:%02lld:%03lld", us, min, sec, milli);
+  }
+  return text;
+}
+
+#endif // SEEED_BOT_TIME_CONVERSION_HPP
@@ -0,0 +1,280 @@
+/**
+* ARSLab - Carleton University
+*
+* Trace Index:
+* Sidecar time index for the text traces, so a time window or the value of a pin at a time can
+* be read without scanning the whole file. Two kinds of files are handled the same way:
+*   pin files   the .txt files of inputs/ and outputs/: every line is "HH:MM:SS:mmm value"
+*   logs        seeed_bot_test_output.txt: a line holding only a time (the global time logger)
+*               starts the lines logged at that time
+* An event is a line that starts with a time; lines without one belong to the previous event.
+*
+* The index (<trace>.idx) holds the time and byte offset of every block_size-th event:
+*   header   "STI2" | block size (u32) | entry count (u64) | event count (u64) | trace size in bytes (u64)
+*            | trace modification time (i64) | hash of the first and last 4 KiB of the trace (u64)
+*   entry    time in microseconds (i64) | byte offset (u64)
+* seek() is a binary search over the entries followed by a scan of at most one block. An index
+* is stale, and rebuilt by TraceIndex::open(), when the size, the modification time or the hash
+* of the trace does not match: a trace rewritten with the same size is caught by its time, and
+* one copied over with its time kept by its first or last lines. "STI1" indexes (size only) are
+* always rebuilt.
+*
+*   TraceIndex index = TraceIndex::open("outputs/D8_RightMotor1_Out.txt");
+*   std::string value;
+*   if(index.value_at(2500000, value)) ...
+*   index.window(1000000, 2000000, [](long long time_us, const std::string& line) { ... });
+*
+* Event times must not decrease. Desktop only.
+*/
+#ifndef SEEED_BOT_TRACE_INDEX_HPP
+#define SEEED_BOT_TRACE_INDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "binary_trace.hpp"
+#include "time_conversion.hpp"
+
+namespace trace_index {
+  constexpr char magic[4] = {'S', 'T', 'I', '2'};
+  constexpr std::size_t header_size = 48;
+  constexpr uint32_t default_block_size = 1024;
+  constexpr long long edge_size = 4096; // bytes hashed at each end of the trace
+
+  // Time at the start of an event line ("HH:MM:SS:mmm", optionally ":uuu") and the rest of
+  // the line after it. The four fields are required, so log text starting with a digit is not
+  // taken for a time.
+  inline bool line_time(const std::string& line, long long& us, std::string& rest) {
+    const char* end;
+    if(!parse_time_string(line.c_str(), us, &end)) return false;
+    int colons = 0;
+    for(const char* p = line.c_str(); p < end; p++) colons += *p == ':';
+    if(colons < 3 || (*end != '\0' && *end != ' ' && *end != '\t' && *end != '\r')) return false;
+    while(*end == ' ' || *end == '\t') end++;
+    rest.assign(end);
+    if(!rest.empty() && rest.back() == '\r') rest.pop_back();
+    return true;
+  }
+
+  inline void put_u32(std::ostream& os, uint32_t v) {
+    for(int i = 0; i < 4; i++) os.put((char) ((v >> (8 * i)) & 0xFF));
+  }
+
+  inline uint32_t get_u32(const uint8_t* p) {
+    uint32_t v = 0;
+    for(int i = 0; i < 4; i++) v |= (uint32_t) p[i] << (8 * i);
+    return v;
+  }
+
+  inline std::string sidecar(const std::string& trace) {
+    return trace + ".idx";
+  }
+
+  inline long long file_size(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return in ? (long long) in.tellg() : -1;
+  }
+
+  // Modification time in ticks of the file clock, 0 if it cannot be read.
+  inline long long file_time(const std::string& path) {
+    std::error_code error;
+    const auto time = std::filesystem::last_write_time(path, error);
+    return error ? 0 : (long long) time.time_since_epoch().count();
+  }
+
+  // FNV-1a hash of the first and the last edge_size bytes of the file (once if they overlap).
+  inline uint64_t edge_hash(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if(!in) return 0;
+    const long long size = (long long) in.tellg();
+    char block[edge_size];
+    uint64_t hash = 14695981039346656037ULL;
+    const long long starts[2] = {0, size > 2 * edge_size ? size - edge_size : edge_size};
+    for(long long start : starts) {
+      if(start >= size) break;
+      in.seekg((std::streamoff) start);
+      in.read(block, (std::streamsize) std::min(edge_size, size - start));
+      for(std::streamsize i = 0; i < in.gcount(); i++) {
+        hash = (hash ^ (uint8_t) block[i]) * 1099511628211ULL;
+      }
+    }
+    return hash;
+  }
+}
+
+class TraceIndex {
+    public:
+        struct entry {
+          long long time_us;
+          uint64_t offset;
+        };
+
+        TraceIndex() : block(trace_index::default_block_size), count(0), trace_size(0), trace_time(0), trace_hash(0) {}
+
+        // Scans the whole trace once.
+        static TraceIndex build(const std::string& trace, uint32_t block_size = trace_index::default_block_size) {
+          std::ifstream in(trace, std::ios::binary);
+          if(!in) {
+            throw std::runtime_error("cannot open trace " + trace);
+          }
+          TraceIndex index(trace, block_size > 0 ? block_size : 1);
+          std::string line, rest;
+          uint64_t offset = 0;
+          long long last_us = 0;
+          while(std::getline(in, line)) {
+            long long us;
+            if(trace_index::line_time(line, us, rest)) {
+              if(index.count > 0 && us < last_us) {
+                throw std::runtime_error("trace events are not in time order: " + trace);
+              }
+              if(index.count % index.block == 0) index.entries.push_back({us, offset});
+              index.count++;
+              last_us = us;
+            }
+            offset += line.size() + 1;
+          }
+          index.trace_size = trace_index::file_size(trace);
+          index.trace_time = trace_index::file_time(trace);
+          index.trace_hash = trace_index::edge_hash(trace);
+          return index;
+        }
+
+        // Reads the saved index of trace. False when it is missing or stale.
+        static bool load(const std::string& trace, TraceIndex& index) {
+          std::ifstream in(trace_index::sidecar(trace), std::ios::binary);
+          uint8_t header[trace_index::header_size];
+          if(!in.read((char*) header, sizeof(header)) || std::memcmp(header, trace_index::magic, 4) != 0) return false;
+          const uint32_t block_size = trace_index::get_u32(header + 4);
+          const uint64_t count = binary_trace::get_u64(header + 8);
+          const uint64_t events = binary_trace::get_u64(header + 16);
+          const long long size = (long long) binary_trace::get_u64(header + 24);
+          const long long time = (long long) binary_trace::get_u64(header + 32);
+          const uint64_t hash = binary_trace::get_u64(header + 40);
+          if(block_size == 0 || size != trace_index::file_size(trace) || time != trace_index::file_time(trace)) return false;
+          if(hash != trace_index::edge_hash(trace)) return false;
+          std::vector<uint8_t> raw(count * 16);
+          if(!in.read((char*) raw.data(), raw.size())) return false;
+          index = TraceIndex(trace, block_size);
+          index.trace_size = size;
+          index.trace_time = time;
+          index.trace_hash = hash;
+          index.count = events;
+          index.entries.resize(count);
+          for(uint64_t i = 0; i < count; i++) {
+            index.entries[i] = {(long long) binary_trace::get_u64(&raw[i * 16]), binary_trace::get_u64(&raw[i * 16 + 8])};
+          }
+          return true;
+        }
+
+        // The saved index if it is up to date, otherwise a new one, saved next to the trace.
+        static TraceIndex open(const std::string& trace, uint32_t block_size = trace_index::default_block_size) {
+          TraceIndex index;
+          if(load(trace, index)) return index;
+          index = build(trace, block_size);
+          index.save();
+          return index;
+        }
+
+        void save() const {
+          std::ofstream out(trace_index::sidecar(path), std::ios::binary | std::ios::trunc);
+          if(!out) {
+            throw std::runtime_error("cannot write " + trace_index::sidecar(path));
+          }
+          out.write(trace_index::magic, 4);
+          trace_index::put_u32(out, block);
+          binary_trace::put_u64(out, entries.size());
+          binary_trace::put_u64(out, count);
+          binary_trace::put_u64(out, (uint64_t) trace_size);
+          binary_trace::put_u64(out, (uint64_t) trace_time);
+          binary_trace::put_u64(out, trace_hash);
+          for(const entry& e : entries) {
+            binary_trace::put_u64(out, (uint64_t) e.time_us);
+            binary_trace::put_u64(out, e.offset);
+          }
+        }
+
+        // Byte offset to start scanning from to find the events at time_us and after: the start
+        // of the last block whose first event is before time_us, or the first block.
+        uint64_t seek(long long time_us) const {
+          std::size_t low = 0, high = entries.size();
+          while(low < high) {
+            const std::size_t mid = (low + high) / 2;
+            if(entries[mid].time_us < time_us) low = mid + 1; else high = mid;
+          }
+          return low > 0 ? entries[low - 1].offset : 0;
+        }
+
+        // Calls on_line(time_us, line) for every line of the events in [from_us, to_us],
+        // including the lines without a time that follow them (log messages).
+        template<typename CALLBACK>
+        unsigned long window(long long from_us, long long to_us, CALLBACK on_line) const {
+          std::ifstream in = reader(seek(from_us));
+          std::string line, rest;
+          long long current = -1;
+          unsigned long lines = 0;
+          while(std::getline(in, line)) {
+            long long us;
+            if(trace_index::line_time(line, us, rest)) {
+              if(us > to_us) break;
+              current = us;
+            }
+            if(current >= from_us) {
+              if(!line.empty() && line.back() == '\r') line.pop_back();
+              on_line(current, line);
+              lines++;
+            }
+          }
+          return lines;
+        }
+
+        // Value of the last event at or before time_us (the text after the time), for pin files.
+        // False if the trace starts after time_us.
+        bool value_at(long long time_us, std::string& value) const {
+          // The last event at or before time_us may be the last one of the previous block.
+          std::ifstream in = reader(seek(time_us));
+          std::string line, rest;
+          bool found = false;
+          while(std::getline(in, line)) {
+            long long us;
+            if(!trace_index::line_time(line, us, rest)) continue;
+            if(us > time_us) break;
+            value = rest;
+            found = true;
+          }
+          return found;
+        }
+
+        const std::string& trace() const { return path; }
+        uint32_t block_size() const { return block; }
+        uint64_t events() const { return count; }
+        const std::vector<entry>& blocks() const { return entries; }
+
+    private:
+        TraceIndex(const std::string& trace, uint32_t block_size) : path(trace), block(block_size), count(0), trace_size(0), trace_time(0), trace_hash(0) {}
+
+        std::ifstream reader(uint64_t offset) const {
+          std::ifstream in(path, std::ios::binary);
+          if(!in) {
+            throw std::runtime_error("cannot open trace " + path);
+          }
+          in.seekg((std::streamoff) offset);
+          return in;
+        }
+
+        std::string path;
+        uint32_t block;
+        uint64_t count; // events in the trace
+        long long trace_size;
+        long long trace_time; // file clock ticks
+        uint64_t trace_hash;  // edge_hash()
+        std::vector<entry> entries;
+};
+
+#endif // SEEED_BOT_TRACE_INDEX_HPP